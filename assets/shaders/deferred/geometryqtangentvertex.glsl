@@ -0,0 +1,35 @@
+#version 300 es
+
+uniform mat4 u_Projection;
+uniform mat4 u_View;
+uniform mat4 u_World;
+
+in vec4 a_Position;
+in vec4 a_QTangent; /* Tangent frame, w < 0 flips the bitangent */
+in vec2 a_TexCoord;
+
+out vec3 v_NormalVS;
+out vec3 v_TangentVS;
+out vec3 v_BitangentVS;
+out vec2 v_TexCoord;
+
+void main(void) {
+    mat3 world3 = mat3(u_World);
+    mat3 view3 = mat3(u_View);
+
+    vec4 q = normalize(a_QTangent);
+    vec3 tangent = vec3(1.0 - 2.0*(q.y*q.y + q.z*q.z), 2.0*(q.x*q.y + q.z*q.w), 2.0*(q.x*q.z - q.y*q.w));
+    vec3 bitangent = vec3(2.0*(q.x*q.y - q.z*q.w), 1.0 - 2.0*(q.x*q.x + q.z*q.z), 2.0*(q.y*q.z + q.x*q.w));
+    vec3 normal = vec3(2.0*(q.x*q.z + q.y*q.w), 2.0*(q.y*q.z - q.x*q.w), 1.0 - 2.0*(q.x*q.x + q.y*q.y));
+    bitangent *= a_QTangent.w < 0.0 ? -1.0 : 1.0;
+
+    vec4 world_pos = u_World * a_Position;
+    vec4 view_pos = u_View * world_pos;
+
+    v_NormalVS = view3 * world3 * normal;
+    v_TangentVS = view3 * world3 * tangent;
+    v_BitangentVS = view3 * world3 * bitangent;
+    v_TexCoord = a_TexCoord;
+
+    gl_Position = u_Projection * view_pos;
+}
@@ -0,0 +1,44 @@
+uniform mat4 u_Projection;
+uniform mat4 u_View;
+uniform mat4 u_World;
+
+attribute vec4 a_Position;      /* Normalized within the mesh bounds */
+attribute vec4 a_Normal;        /* Octahedral xy */
+attribute vec4 a_Tangent;       /* Octahedral xy, w < 0 flips the bitangent */
+attribute vec2 a_TexCoord;
+attribute vec3 a_PositionScale;
+attribute vec3 a_PositionBias;
+
+varying vec3 v_PositionVS;
+varying vec3 v_NormalVS;
+varying vec3 v_TangentVS;
+varying vec3 v_BitangentVS;
+varying vec2 v_TexCoord;
+
+vec3 octahedral_decode(vec2 e) {
+    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if(v.z < 0.0)
+        v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(v);
+}
+
+void main(void) {
+    mat3 world3 = mat3(u_World);
+    mat3 view3 = mat3(u_View);
+
+    vec4 position = vec4(a_Position.xyz * a_PositionScale + a_PositionBias, 1.0);
+    vec3 normal = octahedral_decode(a_Normal.xy);
+    vec3 tangent = octahedral_decode(a_Tangent.xy);
+    vec3 bitangent = cross(normal, tangent) * (a_Tangent.w < 0.0 ? -1.0 : 1.0);
+
+    vec4 world_pos = u_World * position;
+    vec4 view_pos = u_View * world_pos;
+
+    v_PositionVS = vec3(view_pos);
+    v_NormalVS = view3 * world3 * normal;
+    v_TangentVS = view3 * world3 * tangent;
+    v_BitangentVS = view3 * world3 * bitangent;
+    v_TexCoord = a_TexCoord;
+
+    gl_Position = u_Projection * view_pos;
+}
@@ -0,0 +1,17 @@
+uniform mat4 u_Projection;
+uniform mat4 u_View;
+uniform mat4 u_World;
+
+attribute vec4 a_Position;      /* Normalized within the mesh bounds */
+attribute vec2 a_TexCoord;
+attribute vec3 a_PositionScale;
+attribute vec3 a_PositionBias;
+
+varying vec2 v_TexCoord;
+
+void main(void)
+{
+    vec4 position = vec4(a_Position.xyz * a_PositionScale + a_PositionBias, 1.0);
+    v_TexCoord = a_TexCoord;
+    gl_Position = u_Projection * u_View * u_World * position;
+}
@@ -10,6 +10,7 @@ CXX_STD = -std=c++98
 WARNINGS    +=
 
 LOCAL_MODULE    := libandroidinterface
+LOCAL_ARM_NEON  := true
 LOCAL_CFLAGS    := $(INCLUDES) $(WARNINGS) $(C_STD) -v
 LOCAL_CXXFLAGS  := $(INCLUDES) $(WARNINGS) $(CXX_STD)
 LOCAL_SRC_FILES := 	jni.c \
@@ -18,14 +19,20 @@ LOCAL_SRC_FILES := 	jni.c \
 				../../../../../../src/timer.c \
                     ../../../../../../src/game.c \
                     ../../../../../../src/mesh.c \
+                    ../../../../../../src/vertex.c \
                     ../../../../../../src/program.c \
                     ../../../../../../src/forward.c \
                     ../../../../../../src/light_prepass.c \
                     ../../../../../../src/deferred.c \
                     ../../../../../../src/ui.c \
                     ../../../../../../src/utility.c \
+                    ../../../../../../src/frame_arena.c \
+                    ../../../../../../src/transform_batch.c \
+                    ../../../../../../src/frustum.c \
+                    ../../../../../../src/parallel.c \
                     ../../../../../../src/texture.c \
                     ../../../../../../src/scene.cpp \
+                    ../../../../../../src/scene_data.cpp \
                     ../../../../../../external/stb_image.c
 LOCAL_LDLIBS := -lGLESv3 -lEGL -llog -landroid
 
@@ -1,5 +1,6 @@
 #include <jni.h>
 #include <sys/types.h>
+#include <string.h>
 #include <android/asset_manager_jni.h>
 #include "game.h"
 #include "system.h"
@@ -7,6 +8,7 @@
 #define UNUSED_PARAMETER(param) (void)sizeof((param))
 
 extern AAssetManager* _asset_manager;
+extern char _cache_directory[256];
 
 static Game* _game = NULL;
 
@@ -33,6 +35,14 @@ JNIEXPORT void JNICALL Java_com_intel_deferredgles_JNIWrapper_init_1asset_1manag
     UNUSED_PARAMETER(env);
     UNUSED_PARAMETER(obj);
 }
+JNIEXPORT void JNICALL Java_com_intel_deferredgles_JNIWrapper_init_1cache_1directory(JNIEnv * env, jobject obj, jstring path)
+{
+    const char* path_chars = (*env)->GetStringUTFChars(env, path, NULL);
+    strlcpy(_cache_directory, path_chars, sizeof(_cache_directory));
+    (*env)->ReleaseStringUTFChars(env, path, path_chars);
+
+    UNUSED_PARAMETER(obj);
+}
 JNIEXPORT void JNICALL Java_com_intel_deferredgles_JNIWrapper_frame(JNIEnv * env, jobject obj)
 {
     update_game(_game);
@@ -28,6 +28,7 @@ public class JNIWrapper
     public static native void init(int width, int height);
     public static native void resize(int width, int height);
     public static native void init_asset_manager(AssetManager asset_manager);
+    public static native void init_cache_directory(String path);
     public static native void frame();
 
     public static native void touch_down(int index, float x, float y);
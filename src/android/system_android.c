@@ -30,6 +30,7 @@
 /* Constants
  */
 AAssetManager* _asset_manager = NULL;
+char _cache_directory[256] = {0};
 
 /* Variables
  */
@@ -58,6 +59,88 @@ int load_file_data(const char* filename, void** data, size_t* data_size)
     }
     return 0;
 }
+int map_file_data(const char* filename, const void** data, size_t* data_size, void** handle)
+{
+    /* Assets stored uncompressed in the APK are mapped directly */
+    AAsset* file = AAssetManager_open(_asset_manager, filename, AASSET_MODE_BUFFER);
+    if(file == NULL)
+        return -1;
+    *data = AAsset_getBuffer(file);
+    if(*data == NULL) {
+        AAsset_close(file);
+        return -1;
+    }
+    *data_size = (size_t)AAsset_getLength(file);
+    *handle = file;
+    return 0;
+}
+void unmap_file_data(void* handle)
+{
+    AAsset_close((AAsset*)handle);
+}
+FileStream* open_file_stream(const char* filename)
+{
+    return (FileStream*)AAssetManager_open(_asset_manager, filename, AASSET_MODE_STREAMING);
+}
+size_t read_file_stream(FileStream* stream, void* buffer, size_t size)
+{
+    /* Compressed assets can return less than asked before the end */
+    size_t total = 0;
+    while(total < size) {
+        int bytes = AAsset_read((AAsset*)stream, (char*)buffer + total, size - total);
+        if(bytes <= 0)
+            break;
+        total += (size_t)bytes;
+    }
+    return total;
+}
+void close_file_stream(FileStream* stream)
+{
+    AAsset_close((AAsset*)stream);
+}
+int load_cache_data(const char* filename, void** data, size_t* data_size)
+{
+    char    path[512];
+    FILE*   file = NULL;
+    long    file_size;
+
+    if(_cache_directory[0] == '\0')
+        return -1;
+    snprintf(path, sizeof(path), "%s/%s", _cache_directory, filename);
+    file = fopen(path, "rb");
+    if(file == NULL)
+        return -1;
+
+    fseek(file, 0, SEEK_END);
+    file_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    *data = malloc(file_size);
+    *data_size = file_size;
+    if(*data == NULL || fread(*data, file_size, 1, file) != 1) {
+        free(*data);
+        fclose(file);
+        return -1;
+    }
+    fclose(file);
+    return 0;
+}
+int save_cache_data(const char* filename, const void* data, size_t data_size)
+{
+    char    path[512];
+    FILE*   file = NULL;
+    size_t  written;
+
+    if(_cache_directory[0] == '\0')
+        return -1;
+    snprintf(path, sizeof(path), "%s/%s", _cache_directory, filename);
+    file = fopen(path, "wb");
+    if(file == NULL)
+        return -1;
+    written = fwrite(data, data_size, 1, file);
+    fclose(file);
+    return written == 1 ? 0 : -1;
+}
 void system_log(const char* format, ...)
 {
     va_list args;
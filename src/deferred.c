@@ -35,6 +35,7 @@ struct DeferredRenderer
 
     GLuint  cube_vertex_buffer;
     GLuint  cube_index_buffer;
+    GLuint  cube_vertex_array;
 
     GLuint  gbuffer_framebuffer;
     GLuint  gbuffer[GBUFFER_SIZE];
@@ -71,6 +72,13 @@ struct DeferredRenderer
 
 /* Constants
  */
+static const char* kGeometryVertexShaders[kNumVertexFormats] =
+{
+    "shaders/deferred/geometryvertex.glsl",           /* kVertexFormatFloat */
+    "shaders/deferred/geometryqtangentvertex.glsl",   /* kVertexFormatQTangent */
+    "shaders/deferred/geometrycompressedvertex.glsl", /* kVertexFormatCompressed */
+};
+
 /* cube vertices
  *
  *               5---------4
@@ -120,9 +128,7 @@ static const uint16_t kCubeIndices[] =
  */
 static void _draw_point_light(DeferredRenderer* R)
 {
-    ASSERT_GL(glBindBuffer(GL_ARRAY_BUFFER, R->cube_vertex_buffer));
-    ASSERT_GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, R->cube_index_buffer));
-    ASSERT_GL(glVertexAttribPointer(kPositionSlot, 3, GL_FLOAT, GL_FALSE, sizeof(Vec3), (void*)0));
+    ASSERT_GL(glBindVertexArray(R->cube_vertex_array));
     ASSERT_GL(glDrawElements(GL_TRIANGLES, sizeof(kCubeIndices)/sizeof(kCubeIndices[0]), GL_UNSIGNED_SHORT, NULL));
 }
 
@@ -130,14 +136,7 @@ static void _draw_point_light(DeferredRenderer* R)
  */
 DeferredRenderer* create_deferred_renderer(Graphics* G)
 {
-    AttributeSlot geometry_slots[] = {
-        kPositionSlot,
-        kNormalSlot,
-        kTangentSlot,
-        kBitangentSlot,
-        kTexCoordSlot,
-        kEmptySlot
-    };
+    const AttributeSlot* geometry_slots = get_mesh_attribute_slots();
     AttributeSlot light_slots[] = {
         kPositionSlot,
         kEmptySlot
@@ -146,17 +145,23 @@ DeferredRenderer* create_deferred_renderer(Graphics* G)
     int i[] = {0,1,2};
     int ii;
 
+    /* Create vertex array */
+    ASSERT_GL(glGenVertexArrays(1, &R->cube_vertex_array));
+    ASSERT_GL(glBindVertexArray(R->cube_vertex_array));
+
     /* Create vertex buffer */
     ASSERT_GL(glGenBuffers(1, &R->cube_vertex_buffer));
     ASSERT_GL(glBindBuffer(GL_ARRAY_BUFFER, R->cube_vertex_buffer));
     ASSERT_GL(glBufferData(GL_ARRAY_BUFFER, sizeof(kCubeVertices), kCubeVertices, GL_STATIC_DRAW));
+    ASSERT_GL(glEnableVertexAttribArray(kPositionSlot));
+    ASSERT_GL(glVertexAttribPointer(kPositionSlot, 3, GL_FLOAT, GL_FALSE, sizeof(Vec3), (void*)0));
     ASSERT_GL(glBindBuffer(GL_ARRAY_BUFFER, 0));
 
     /* Create index buffer */
     ASSERT_GL(glGenBuffers(1, &R->cube_index_buffer));
     ASSERT_GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, R->cube_index_buffer));
     ASSERT_GL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(kCubeIndices), kCubeIndices, GL_STATIC_DRAW));
-    ASSERT_GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+    ASSERT_GL(glBindVertexArray(0));
 
     /** Create Gbuffer
      */
@@ -167,7 +172,7 @@ DeferredRenderer* create_deferred_renderer(Graphics* G)
 
     /** Geometry pass
      */
-    R->geometry.program = create_program("shaders/deferred/geometryvertex.glsl",
+    R->geometry.program = create_program(kGeometryVertexShaders[get_vertex_format()],
                                          "shaders/deferred/geometryfragment.glsl",
                                          geometry_slots);
 
@@ -179,13 +184,6 @@ DeferredRenderer* create_deferred_renderer(Graphics* G)
     ASSERT_GL(GetUniformLocation(R, geometry, program, s_Albedo));
 
     ASSERT_GL(glUseProgram(R->geometry.program));
-
-    ASSERT_GL(glEnableVertexAttribArray(kPositionSlot));
-    ASSERT_GL(glEnableVertexAttribArray(kNormalSlot));
-    ASSERT_GL(glEnableVertexAttribArray(kTangentSlot));
-    ASSERT_GL(glEnableVertexAttribArray(kBitangentSlot));
-    ASSERT_GL(glEnableVertexAttribArray(kTexCoordSlot));
-
     ASSERT_GL(glUniform1i(R->geometry.s_Albedo, 0));
     ASSERT_GL(glUniform1i(R->geometry.s_Normal, 1));
     ASSERT_GL(glUseProgram(0));
@@ -208,12 +206,6 @@ DeferredRenderer* create_deferred_renderer(Graphics* G)
     ASSERT_GL(GetUniformLocation(R, light, program, u_LightPosition));
     ASSERT_GL(GetUniformLocation(R, light, program, u_LightSize));
 
-    ASSERT_GL(glUseProgram(R->light.program));
-
-    ASSERT_GL(glEnableVertexAttribArray(kPositionSlot));
-
-    ASSERT_GL(glUseProgram(0));
-
     if(R->geometry.program == 0 ||
        R->light.program == 0) {
         /* Failed to create programs. Return NULL */
@@ -235,7 +227,7 @@ void resize_deferred_renderer(DeferredRenderer* R, int width, int height)
 
 void render_deferred(DeferredRenderer* R, GLuint default_framebuffer,
                      Mat4 proj_matrix, Mat4 view_matrix,
-                     const Model* models, int num_models,
+                     const RenderQueue* queue,
                      const Light* lights, int num_lights)
 {
     GLenum buffers[] = {
@@ -243,6 +235,7 @@ void render_deferred(DeferredRenderer* R, GLuint default_framebuffer,
     };
     Mat4 inv_proj = mat4_inverse(proj_matrix);
     float viewport[] = { R->width, R->height };
+    const Material* material = NULL;
     int ii;
     GLint framebuffer_status;
 
@@ -266,16 +259,22 @@ void render_deferred(DeferredRenderer* R, GLuint default_framebuffer,
     ASSERT_GL(glUniformMatrix4fv(R->geometry.u_Projection, 1, GL_FALSE, (float*)&proj_matrix));
     ASSERT_GL(glUniformMatrix4fv(R->geometry.u_View, 1, GL_FALSE, (float*)&view_matrix));
 
-    for(ii=0;ii<num_models;++ii) {
-        Mat4 world_matrix = transform_get_matrix(models[ii].transform);
-        /* Material */
-        ASSERT_GL(glActiveTexture(GL_TEXTURE0));
-        ASSERT_GL(glBindTexture(GL_TEXTURE_2D, models[ii].material->albedo));
-        ASSERT_GL(glActiveTexture(GL_TEXTURE1));
-        ASSERT_GL(glBindTexture(GL_TEXTURE_2D, models[ii].material->normal));
+    begin_mesh_draws();
+    for(ii=0;ii<queue->num_items;++ii) {
+        const RenderItem* item = &queue->items[queue->order[0][ii]];
+        const Model* model = item->model;
+        const Mat4* world_matrix = &queue->world_matrices[item->world_matrix];
+        /* Material, only when it changes */
+        if(model->material != material) {
+            material = model->material;
+            ASSERT_GL(glActiveTexture(GL_TEXTURE0));
+            ASSERT_GL(glBindTexture(GL_TEXTURE_2D, material->albedo));
+            ASSERT_GL(glActiveTexture(GL_TEXTURE1));
+            ASSERT_GL(glBindTexture(GL_TEXTURE_2D, material->normal));
+        }
         /* Mesh */
-        ASSERT_GL(glUniformMatrix4fv(R->geometry.u_World, 1, GL_FALSE, (float*)&world_matrix));
-        draw_mesh(models[ii].mesh);
+        ASSERT_GL(glUniformMatrix4fv(R->geometry.u_World, 1, GL_FALSE, (const float*)world_matrix));
+        draw_mesh(model->mesh, item->lod);
     }
     ASSERT_GL(glActiveTexture(GL_TEXTURE0));
     ASSERT_GL(glBindTexture(GL_TEXTURE_2D, 0));
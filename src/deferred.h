@@ -30,7 +30,7 @@ void resize_deferred_renderer(DeferredRenderer* R, int width, int height);
 
 void render_deferred(DeferredRenderer* R, GLuint default_framebuffer,
                      Mat4 proj_matrix, Mat4 view_matrix,
-                     const Model* models, int num_models,
+                     const RenderQueue* queue,
                      const Light* lights, int num_lights);
 
 
@@ -25,6 +25,7 @@
 /* Defines
  */
 #define GetUniformLocation(R, program, uniform) R->uniform = glGetUniformLocation(R->program, #uniform)
+#define MAX_FORWARD_LIGHTS 64 /* Size of the fragment shader's light arrays */
 
 /* Types
  */
@@ -58,6 +59,12 @@ struct ForwardRenderer
 
 /* Constants
  */
+static const char* kVertexShaders[kNumVertexFormats] =
+{
+    "shaders/forward/vertex.glsl",           /* kVertexFormatFloat */
+    "shaders/forward/QTangentVertex.glsl",   /* kVertexFormatQTangent */
+    "shaders/forward/CompressedVertex.glsl", /* kVertexFormatCompressed */
+};
 
 /* Variables
  */
@@ -70,19 +77,12 @@ struct ForwardRenderer
 
 ForwardRenderer* create_forward_renderer(Graphics* G, int major_version, int minor_version)
 {
-    AttributeSlot slots[] = {
-        kPositionSlot,
-        kNormalSlot,
-        kTangentSlot,
-        kBitangentSlot,
-        kTexCoordSlot,
-        kEmptySlot
-    };
+    const AttributeSlot* slots = get_mesh_attribute_slots();
     ForwardRenderer* R = (ForwardRenderer*)calloc(1,sizeof(*R));
     R->major_version = major_version;
     R->minor_version = minor_version;
 
-    R->program = create_program("shaders/forward/vertex.glsl", "shaders/forward/fragment.glsl", slots);
+    R->program = create_program(kVertexShaders[get_vertex_format()], "shaders/forward/fragment.glsl", slots);
 
     ASSERT_GL(GetUniformLocation(R, program, u_Projection));
     ASSERT_GL(GetUniformLocation(R, program, u_View));
@@ -102,13 +102,6 @@ ForwardRenderer* create_forward_renderer(Graphics* G, int major_version, int min
     ASSERT_GL(GetUniformLocation(R, program, u_SpecularCoefficient));
 
     ASSERT_GL(glUseProgram(R->program));
-
-    ASSERT_GL(glEnableVertexAttribArray(kPositionSlot));
-    ASSERT_GL(glEnableVertexAttribArray(kNormalSlot));
-    ASSERT_GL(glEnableVertexAttribArray(kTangentSlot));
-    ASSERT_GL(glEnableVertexAttribArray(kBitangentSlot));
-    ASSERT_GL(glEnableVertexAttribArray(kTexCoordSlot));
-
     ASSERT_GL(glUniform1i(R->s_Albedo, 0));
     ASSERT_GL(glUniform1i(R->s_Normal, 1));
     ASSERT_GL(glUseProgram(0));
@@ -128,16 +121,20 @@ void resize_forward_renderer(ForwardRenderer* R, int width, int height)
 
 void render_forward(ForwardRenderer* R, GLuint default_framebuffer,
                     Mat4 proj_matrix, Mat4 view_matrix,
-                    const Model* models, int num_models,
+                    const RenderQueue* queue,
                     const Light* lights, int num_lights)
 {
     //Mat4    inv_view = mat4_inverse(view_matrix);
     //Mat4    inv_proj = mat4_inverse(proj_matrix);
-    Vec3    light_positions[MAX_LIGHTS];
-    Vec3    light_colors[MAX_LIGHTS];
-    float   light_sizes[MAX_LIGHTS];
+    Vec3    light_positions[MAX_FORWARD_LIGHTS];
+    Vec3    light_colors[MAX_FORWARD_LIGHTS];
+    float   light_sizes[MAX_FORWARD_LIGHTS];
+    const Material* material = NULL;
     int     ii;
 
+    if(num_lights > MAX_FORWARD_LIGHTS)
+        num_lights = MAX_FORWARD_LIGHTS;
+
     /* Fill out light buffer and transform to view space */
     for(ii=0;ii<num_lights;++ii) {
         Vec4 position = vec4_from_vec3(lights[ii].position, 1.0f);
@@ -160,18 +157,24 @@ void render_forward(ForwardRenderer* R, GLuint default_framebuffer,
     ASSERT_GL(glUniform1fv(R->u_LightSizes, num_lights, (float*)light_sizes));
     ASSERT_GL(glUniform1i(R->u_NumLights, num_lights));
 
-    for(ii=0;ii<num_models;++ii) {
-        Mat4 world_matrix = transform_get_matrix(models[ii].transform);
-        /* Material */
-        ASSERT_GL(glUniform3fv(R->u_SpecularColor, 1, (float*)&models[ii].material->specular_color));
-        ASSERT_GL(glUniform1f(R->u_SpecularPower, models[ii].material->specular_power));
-        ASSERT_GL(glUniform1f(R->u_SpecularCoefficient, models[ii].material->specular_coefficient));
-        ASSERT_GL(glActiveTexture(GL_TEXTURE0));
-        ASSERT_GL(glBindTexture(GL_TEXTURE_2D, models[ii].material->albedo));
-        ASSERT_GL(glActiveTexture(GL_TEXTURE1));
-        ASSERT_GL(glBindTexture(GL_TEXTURE_2D, models[ii].material->normal));
+    begin_mesh_draws();
+    for(ii=0;ii<queue->num_items;++ii) {
+        const RenderItem* item = &queue->items[queue->order[0][ii]];
+        const Model* model = item->model;
+        const Mat4* world_matrix = &queue->world_matrices[item->world_matrix];
+        /* Material, only when it changes */
+        if(model->material != material) {
+            material = model->material;
+            ASSERT_GL(glUniform3fv(R->u_SpecularColor, 1, (float*)&material->specular_color));
+            ASSERT_GL(glUniform1f(R->u_SpecularPower, material->specular_power));
+            ASSERT_GL(glUniform1f(R->u_SpecularCoefficient, material->specular_coefficient));
+            ASSERT_GL(glActiveTexture(GL_TEXTURE0));
+            ASSERT_GL(glBindTexture(GL_TEXTURE_2D, material->albedo));
+            ASSERT_GL(glActiveTexture(GL_TEXTURE1));
+            ASSERT_GL(glBindTexture(GL_TEXTURE_2D, material->normal));
+        }
         /* Mesh */
-        ASSERT_GL(glUniformMatrix4fv(R->u_World, 1, GL_FALSE, (float*)&world_matrix));
-        draw_mesh(models[ii].mesh);
+        ASSERT_GL(glUniformMatrix4fv(R->u_World, 1, GL_FALSE, (const float*)world_matrix));
+        draw_mesh(model->mesh, item->lod);
     }
 }
@@ -29,7 +29,7 @@ void resize_forward_renderer(ForwardRenderer* R, int width, int height);
 
 void render_forward(ForwardRenderer* R, GLuint default_framebuffer,
                     Mat4 proj_matrix, Mat4 view_matrix,
-                    const Model* models, int num_models,
+                    const RenderQueue* queue,
                     const Light* lights, int num_lights);
 
 #endif /* include guard */
@@ -0,0 +1,144 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "frame_arena.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "assert.h"
+
+/* Defines
+ */
+#define FRAME_ALIGNMENT 16
+#define ALIGN_SIZE(size) (((size) + FRAME_ALIGNMENT - 1) & ~(size_t)(FRAME_ALIGNMENT - 1))
+
+/* Types
+ */
+typedef struct FrameBlock
+{
+    struct FrameBlock*  next;   /* The block filled before this one */
+    uint8_t*            data;
+    size_t              size;
+    size_t              used;
+} FrameBlock;
+
+struct FrameArena
+{
+    FrameBlock* block;      /* The block being filled */
+    size_t      capacity;   /* Summed over all blocks */
+    size_t      used;       /* Summed over all blocks */
+    size_t      high_water;
+};
+
+/* Constants
+ */
+
+/* Variables
+ */
+
+/* Internal functions
+ */
+static FrameBlock* _create_block(size_t size, FrameBlock* next)
+{
+    FrameBlock* block = (FrameBlock*)malloc(sizeof(FrameBlock) + size + FRAME_ALIGNMENT);
+    uintptr_t data = (uintptr_t)(block + 1);
+    assert(block);
+    block->next = next;
+    block->data = (uint8_t*)ALIGN_SIZE(data);
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+static void _destroy_blocks(FrameBlock* block)
+{
+    while(block) {
+        FrameBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+}
+
+/* External functions
+ */
+FrameArena* create_frame_arena(size_t size)
+{
+    FrameArena* A = (FrameArena*)calloc(1, sizeof(FrameArena));
+    A->capacity = ALIGN_SIZE(size);
+    A->block = _create_block(A->capacity, NULL);
+    return A;
+}
+void destroy_frame_arena(FrameArena* A)
+{
+    if(A == NULL)
+        return;
+    _destroy_blocks(A->block);
+    free(A);
+}
+void* allocate_frame_memory(FrameArena* A, size_t size)
+{
+    FrameBlock* block = A->block;
+    void* ptr;
+    size = ALIGN_SIZE(size);
+    if(block->used + size > block->size) {
+        /* Double the arena, and at least fit this allocation */
+        size_t block_size = A->capacity > size ? A->capacity : size;
+        block = A->block = _create_block(block_size, block);
+        A->capacity += block_size;
+    }
+    ptr = block->data + block->used;
+    block->used += size;
+    A->used += size;
+    if(A->used > A->high_water)
+        A->high_water = A->used;
+    return ptr;
+}
+void* reallocate_frame_memory(FrameArena* A, void* ptr, size_t old_size, size_t new_size)
+{
+    FrameBlock* block = A->block;
+    void* new_ptr;
+    old_size = ALIGN_SIZE(old_size);
+    new_size = ALIGN_SIZE(new_size);
+    if(ptr == NULL)
+        return allocate_frame_memory(A, new_size);
+    if(new_size <= old_size)
+        return ptr;
+    if((uint8_t*)ptr + old_size == block->data + block->used &&
+       block->used - old_size + new_size <= block->size) {
+        /* Last allocation, grow in place */
+        block->used += new_size - old_size;
+        A->used += new_size - old_size;
+        if(A->used > A->high_water)
+            A->high_water = A->used;
+        return ptr;
+    }
+    new_ptr = allocate_frame_memory(A, new_size);
+    memcpy(new_ptr, ptr, old_size);
+    return new_ptr;
+}
+void reset_frame_arena(FrameArena* A)
+{
+    if(A->block->next) {
+        /* Merge the blocks so the next frame fits in one */
+        _destroy_blocks(A->block);
+        A->block = _create_block(A->capacity, NULL);
+    }
+    A->block->used = 0;
+    A->used = 0;
+}
+size_t get_frame_arena_high_water(const FrameArena* A)
+{
+    return A->high_water;
+}
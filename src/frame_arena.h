@@ -0,0 +1,45 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __frame_arena_h__
+#define __frame_arena_h__
+
+#include <stddef.h>
+
+/** A linear allocator for data that lives for one frame. Allocations are
+ *  16 byte aligned and freed all at once by `reset_frame_arena`. When a
+ *  frame outgrows the arena it adds a block, and the reset merges the
+ *  blocks into one, so frames that fit never call malloc
+ */
+typedef struct FrameArena FrameArena;
+
+FrameArena* create_frame_arena(size_t size);
+void destroy_frame_arena(FrameArena* A);
+
+void* allocate_frame_memory(FrameArena* A, size_t size);
+/** @brief Grows an allocation, in place when it's the arena's last one
+ *  @return The allocation, holding the first `old_size` bytes of `ptr`
+ */
+void* reallocate_frame_memory(FrameArena* A, void* ptr, size_t old_size, size_t new_size);
+/** @brief Frees everything allocated since the last reset
+ */
+void reset_frame_arena(FrameArena* A);
+
+/** @return The most bytes allocated in any one frame so far
+ */
+size_t get_frame_arena_high_water(const FrameArena* A);
+
+#endif /* include guard */
@@ -0,0 +1,165 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "frustum.h"
+#include "simd.h"
+
+/* Defines
+ */
+
+/* Types
+ */
+
+/* Constants
+ */
+
+/* Variables
+ */
+
+/* Internal functions
+ */
+static Vec4 _normalize_plane(Vec4 plane)
+{
+    float length = sqrtf(plane.x*plane.x + plane.y*plane.y + plane.z*plane.z);
+    return vec4_div_scalar(plane, length);
+}
+
+/* External functions
+ */
+Frustum frustum_from_matrix(Mat4 view_proj)
+{
+    /* Points transform as row vectors, so clip x, y, z and w are dot
+     * products with the matrix's columns
+     */
+    Mat4 columns = mat4_transpose(view_proj);
+    Frustum frustum;
+    frustum.planes[0] = _normalize_plane(vec4_add(columns.r3, columns.r0));
+    frustum.planes[1] = _normalize_plane(vec4_sub(columns.r3, columns.r0));
+    frustum.planes[2] = _normalize_plane(vec4_add(columns.r3, columns.r1));
+    frustum.planes[3] = _normalize_plane(vec4_sub(columns.r3, columns.r1));
+    frustum.planes[4] = _normalize_plane(vec4_add(columns.r3, columns.r2));
+    frustum.planes[5] = _normalize_plane(vec4_sub(columns.r3, columns.r2));
+    return frustum;
+}
+int frustum_intersects_sphere(const Frustum* frustum, Vec3 center, float radius)
+{
+    int ii;
+    for(ii=0;ii<6;++ii) {
+        const Vec4* plane = &frustum->planes[ii];
+        if(plane->x*center.x + plane->y*center.y + plane->z*center.z + plane->w < -radius)
+            return 0;
+    }
+    return 1;
+}
+int cull_bounds(int* visible, const Frustum* frustum, const Transform* const* transforms,
+                const Vec3* centers, const Vec3* extents, const float* radii, int count)
+{
+    const Simd4 one = simd4_splat(1.0f);
+    const Simd4 two = simd4_splat(2.0f);
+    int num_visible = 0;
+    int ii;
+
+    for(ii=0;ii<count;ii+=4) {
+        /* A partial group repeats its last bounds in the spare lanes */
+        int lanes[4];
+        float cx[4], cy[4], cz[4], ex[4], ey[4], ez[4], r[4], distance[4];
+        Simd4 qx, qy, qz, qw, px, py, pz, s;
+        Simd4 xx, yy, zz, xy, zw, xz, yw, yz, xw;
+        Simd4 r0x, r0y, r0z, r1x, r1y, r1z, r2x, r2y, r2z;
+        Simd4 wx, wy, wz, radius, min_distance;
+        int jj;
+
+        for(jj=0;jj<4;++jj) {
+            int index = ii + jj < count ? ii + jj : count - 1;
+            lanes[jj] = index;
+            cx[jj] = centers[index].x;
+            cy[jj] = centers[index].y;
+            cz[jj] = centers[index].z;
+            ex[jj] = extents[index].x;
+            ey[jj] = extents[index].y;
+            ez[jj] = extents[index].z;
+            r[jj] = radii[index];
+        }
+
+        /* Rotation rows scaled by the transform, as compute_world_matrices
+         * builds them
+         */
+        qx = simd4_load(&transforms[lanes[0]]->orientation.x);
+        qy = simd4_load(&transforms[lanes[1]]->orientation.x);
+        qz = simd4_load(&transforms[lanes[2]]->orientation.x);
+        qw = simd4_load(&transforms[lanes[3]]->orientation.x);
+        px = simd4_load(&transforms[lanes[0]]->position.x);
+        py = simd4_load(&transforms[lanes[1]]->position.x);
+        pz = simd4_load(&transforms[lanes[2]]->position.x);
+        s = simd4_load(&transforms[lanes[3]]->position.x);
+        simd4_transpose(&qx, &qy, &qz, &qw);
+        simd4_transpose(&px, &py, &pz, &s);
+
+        xx = simd4_mul(qx, qx);
+        yy = simd4_mul(qy, qy);
+        zz = simd4_mul(qz, qz);
+        xy = simd4_mul(qx, qy);
+        zw = simd4_mul(qz, qw);
+        xz = simd4_mul(qx, qz);
+        yw = simd4_mul(qy, qw);
+        yz = simd4_mul(qy, qz);
+        xw = simd4_mul(qx, qw);
+
+        r0x = simd4_mul(simd4_sub(one, simd4_mul(two, simd4_add(yy, zz))), s);
+        r0y = simd4_mul(simd4_mul(two, simd4_add(xy, zw)), s);
+        r0z = simd4_mul(simd4_mul(two, simd4_sub(xz, yw)), s);
+        r1x = simd4_mul(simd4_mul(two, simd4_sub(xy, zw)), s);
+        r1y = simd4_mul(simd4_sub(one, simd4_mul(two, simd4_add(xx, zz))), s);
+        r1z = simd4_mul(simd4_mul(two, simd4_add(yz, xw)), s);
+        r2x = simd4_mul(simd4_mul(two, simd4_add(xz, yw)), s);
+        r2y = simd4_mul(simd4_mul(two, simd4_sub(yz, xw)), s);
+        r2z = simd4_mul(simd4_sub(one, simd4_mul(two, simd4_add(xx, yy))), s);
+
+        /* World space center and sphere */
+        {
+            Simd4 lx = simd4_load(cx), ly = simd4_load(cy), lz = simd4_load(cz);
+            wx = simd4_add(simd4_dot3(lx, ly, lz, r0x, r1x, r2x), px);
+            wy = simd4_add(simd4_dot3(lx, ly, lz, r0y, r1y, r2y), py);
+            wz = simd4_add(simd4_dot3(lx, ly, lz, r0z, r1z, r2z), pz);
+            radius = simd4_mul(simd4_load(r), s);
+        }
+
+        /* Signed distance of the bounds' farthest point inside each plane.
+         * Any negative one puts the bounds outside, and only the sign of
+         * the smallest matters
+         */
+        min_distance = one;
+        for(jj=0;jj<6;++jj) {
+            const Vec4* plane = &frustum->planes[jj];
+            Simd4 nx = simd4_splat(plane->x);
+            Simd4 ny = simd4_splat(plane->y);
+            Simd4 nz = simd4_splat(plane->z);
+            Simd4 d = simd4_add(simd4_dot3(nx, ny, nz, wx, wy, wz), simd4_splat(plane->w));
+            Simd4 reach = simd4_mul(simd4_load(ex), simd4_abs(simd4_dot3(nx, ny, nz, r0x, r0y, r0z)));
+            reach = simd4_add(reach, simd4_mul(simd4_load(ey), simd4_abs(simd4_dot3(nx, ny, nz, r1x, r1y, r1z))));
+            reach = simd4_add(reach, simd4_mul(simd4_load(ez), simd4_abs(simd4_dot3(nx, ny, nz, r2x, r2y, r2z))));
+            d = simd4_add(d, simd4_min(reach, radius));
+            min_distance = simd4_min(min_distance, d);
+        }
+        simd4_store(distance, min_distance);
+
+        for(jj=0;jj<4 && ii+jj<count;++jj) {
+            if(distance[jj] >= 0.0f)
+                visible[num_visible++] = ii + jj;
+        }
+    }
+    return num_visible;
+}
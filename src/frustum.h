@@ -0,0 +1,54 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __frustum_h__
+#define __frustum_h__
+
+#include "vec_math.h"
+
+/* Types
+ */
+/** Six world space planes facing into the volume (left, right, bottom, top,
+ *  near, far), with unit normals in xyz and the distance in w
+ */
+typedef struct Frustum
+{
+    Vec4    planes[6];
+} Frustum;
+
+/** @brief Extracts the planes from a world to clip space matrix, using the
+ *      OpenGL clip volume -w <= x, y, z <= w
+ */
+Frustum frustum_from_matrix(Mat4 view_proj);
+
+/** @return Whether the world space sphere touches the frustum
+ */
+int frustum_intersects_sphere(const Frustum* frustum, Vec3 center, float radius);
+
+/** @brief Tests model space bounds placed by their transforms against the
+ *      frustum, four at a time in structure-of-arrays form. A box only
+ *      counts as outside past the nearer of its own and its sphere's reach
+ *  @param visible [out] Indices of the bounds touching the frustum, in order
+ *  @param transforms [in] `count` transforms, gathered through pointers
+ *  @param centers [in] Shared center of each box and sphere
+ *  @param extents [in] Half size of each box
+ *  @param radii [in] Radius of each sphere
+ *  @return The number of indices written to `visible`
+ */
+int cull_bounds(int* visible, const Frustum* frustum, const Transform* const* transforms,
+                const Vec3* centers, const Vec3* extents, const float* radii, int count);
+
+#endif /* include guard */
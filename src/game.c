@@ -38,6 +38,7 @@ struct Game
     int height;
     /* Engine objects */
     Timer*      timer;
+    Timer*      render_timer;
     Graphics*   graphics;
     UI*         ui;
 
@@ -60,6 +61,8 @@ struct Game
     float       fps_time;
     int         fps_count;
     float       fps;
+    float       render_time;
+    float       render_ms;
 };
 
 /* Constants
@@ -117,6 +120,7 @@ Game* create_game(void)
     int ii;
     Game* G = (Game*)calloc(1, sizeof(Game));
     G->timer = create_timer();
+    G->render_timer = create_timer();
     G->graphics = create_graphics();
     G->ui = create_ui(G->graphics);
 
@@ -129,7 +133,11 @@ Game* create_game(void)
 
     /* Load scene */
     reset_timer(G->timer);
-    G->scene = create_scene("lightHouse.obj");
+    G->scene = create_scene("lightHouse.mesh");
+    if(G->scene == NULL)
+        G->scene = create_scene("lightHouse.obj");
+    if(G->scene == NULL)
+        system_log("Unable to load the lighthouse scene\n");
     G->sun_light.position = vec3_create(-4.0f, 5.0f, 2.0f);
     G->sun_light.color = vec3_create(1, 1, 1);
     G->sun_light.size = 35.0f;
@@ -152,8 +160,10 @@ Game* create_game(void)
         G->lights[ii].size = 5;
     }
 
-    get_model(G->scene, 3)->material->specular_color = vec3_create(0.5f, 0.5f, 0.5f);
-    get_model(G->scene, 3)->material->specular_coefficient = 1.0f;
+    if(G->scene) {
+        get_model(G->scene, 3)->material->specular_color = vec3_create(0.5f, 0.5f, 0.5f);
+        get_model(G->scene, 3)->material->specular_coefficient = 1.0f;
+    }
 
     G->dynamic_lights = 1;
 
@@ -163,6 +173,7 @@ Game* create_game(void)
 void destroy_game(Game* G)
 {
     destroy_timer(G->timer);
+    destroy_timer(G->render_timer);
     destroy_graphics(G->graphics);
     free(G);
 }
@@ -197,7 +208,8 @@ void update_game(Game* G)
     for(ii=0;ii<NUM_LIGHTS;++ii) {
         add_light(G->graphics, G->lights[ii]);
     }
-    render_scene(G->scene, G->graphics);
+    if(G->scene)
+        render_scene(G->scene, G->graphics);
 
     G->tap_timer += delta_time;
 
@@ -207,12 +219,15 @@ void update_game(Game* G)
 
     if(G->fps_time >= 1.0f) {
         G->fps = G->fps_count/G->fps_time;
+        G->render_ms = G->render_time*1000.0f/G->fps_count;
         system_log("FPS: %f\n", G->fps);
+        G->render_time = 0.0f;
         G->fps_time -= 1.0f;
         G->fps_count = 0;
     }
     {
         int width, height;
+        int visible, culled;
         float scale = 50.0f;
         float x = -G->width/2.0f;
         float y = G->height/2.0f-scale;
@@ -221,6 +236,19 @@ void update_game(Game* G)
         sprintf(buffer, "FPS: %.2f", G->fps);
         add_string(G->ui, x, y, scale, buffer);
         y -= scale;
+        // CPU time spent issuing the frame's draw calls
+        sprintf(buffer, "Render CPU: %.2f ms", G->render_ms);
+        add_string(G->ui, x, y, scale, buffer);
+        y -= scale;
+        // Models left after frustum culling
+        get_graphics_cull_stats(G->graphics, &visible, &culled);
+        sprintf(buffer, "Models: %d/%d", visible, visible + culled);
+        add_string(G->ui, x, y, scale, buffer);
+        y -= scale;
+        get_graphics_light_cull_stats(G->graphics, &visible, &culled);
+        sprintf(buffer, "Lights: %d/%d", visible, visible + culled);
+        add_string(G->ui, x, y, scale, buffer);
+        y -= scale;
         // Renderer
         switch(renderer_type(G->graphics)) {
         case kForward: add_string(G->ui, x, y, scale, "Forward renderer"); break;
@@ -240,7 +268,9 @@ void update_game(Game* G)
 }
 void render_game(Game* G)
 {
+    get_delta_time(G->render_timer);
     render_graphics(G->graphics);
+    G->render_time += (float)get_delta_time(G->render_timer);
     draw_ui(G->ui);
 }
 void add_touch_points(Game* G, int num_touch_points, TouchPoint* points)
@@ -21,6 +21,11 @@
 #include "gl_include.h"
 #include "program.h"
 #include "vertex.h"
+#include "mesh.h"
+#include "utility.h"
+#include "frame_arena.h"
+#include "transform_batch.h"
+#include "frustum.h"
 
 #include "forward.h"
 #include "light_prepass.h"
@@ -28,9 +33,9 @@
 
 /* Defines
  */
-#define MAX_RENDER_COMMANDS 1024
 #define STATIC_WIDTH 1280
 #define STATIC_HEIGHT 720
+#define CULL_BATCH_SIZE 64 /* Models gathered per culling call */
 
 /* Types
  */
@@ -53,6 +58,7 @@ struct Graphics
     GLuint  fullscreen_program;
     GLuint  fullscreen_quad_vertex_buffer;
     GLuint  fullscreen_quad_index_buffer;
+    GLuint  fullscreen_quad_vertex_array;
     GLuint  fullscreen_texture;
 
     GLuint  framebuffer;
@@ -61,11 +67,31 @@ struct Graphics
 
     Mat4    proj_matrix;
     Mat4    view_matrix;
-
-    Model   render_commands[MAX_RENDER_COMMANDS];
-    Light   lights[MAX_LIGHTS];
-    int     num_render_commands;
+    Frustum frustum;
+
+    /* Per-frame lists, allocated from the frame arena */
+    FrameArena* frame_arena;
+    RenderItem* render_items;
+    Mat4*   world_matrices; /* Indexed by RenderItem::world_matrix, filled by render_graphics */
+    Light*  lights;
+    int     num_render_items;
     int     num_lights;
+    int     max_render_items;
+    int     max_lights;
+    int     prev_num_render_items;
+    int     prev_num_lights;
+
+    /* Render commands kept and dropped by frustum culling, this frame and
+     * the last rendered one, then the last rendered frame's lights
+     */
+    int     num_visible;
+    int     num_culled;
+    int     prev_num_visible;
+    int     prev_num_culled;
+    int     prev_num_visible_lights;
+    int     prev_num_culled_lights;
+
+    SortMode    sort_modes[MAX_RENDERERS][MAX_RENDER_PASSES];
 
     RendererType active_renderer;
 };
@@ -85,6 +111,22 @@ static const uint32_t kFullscreenIndices[] = {
     0, 2, 1,
     0, 3, 2,
 };
+static const float kNearPlane = 1.0f;
+static const float kFarPlane = 100.0f;
+static const size_t kFrameArenaSize = 256*1024;
+static const int kMinListSize = 64;
+static const float kMinLightPixels = 2.0f; /* Smallest projected light radius drawn */
+
+/* Number of passes each renderer draws the models in, and how they're sorted
+ * by default
+ */
+static const int kRendererPasses[MAX_RENDERERS] = { 1, 2, 1 };
+static const SortMode kDefaultSortModes[MAX_RENDERERS][MAX_RENDER_PASSES] =
+{
+    { kSortMaterial },                      /* kForward: shading */
+    { kSortFrontToBack, kSortMaterial },    /* kLightPrePass: normals and depth, then shading */
+    { kSortFrontToBack },                   /* kDeferred: G-buffer */
+};
 
 /* Variables
  */
@@ -98,32 +140,35 @@ static void _create_fullscreen_quad(Graphics* G)
         kTexCoordSlot,
         kEmptySlot
     };
+    float* ptr = 0;
     G->fullscreen_program = create_program("fullscreen_vertex.glsl", "fullscreen_fragment.glsl", slots);
     ASSERT_GL(glUseProgram(G->fullscreen_program));
     ASSERT_GL(G->fullscreen_texture = glGetUniformLocation(G->fullscreen_program, "s_Texture"));
-    ASSERT_GL(glEnableVertexAttribArray(kPositionSlot));
-    ASSERT_GL(glEnableVertexAttribArray(kTexCoordSlot));
     ASSERT_GL(glUseProgram(0));
 
+    /* Create vertex array */
+    ASSERT_GL(glGenVertexArrays(1, &G->fullscreen_quad_vertex_array));
+    ASSERT_GL(glBindVertexArray(G->fullscreen_quad_vertex_array));
+
     /* Create vertex buffer */
     ASSERT_GL(glGenBuffers(1, &G->fullscreen_quad_vertex_buffer));
     ASSERT_GL(glBindBuffer(GL_ARRAY_BUFFER, G->fullscreen_quad_vertex_buffer));
     ASSERT_GL(glBufferData(GL_ARRAY_BUFFER, sizeof(kFullscreenVertices), kFullscreenVertices, GL_STATIC_DRAW));
+    ASSERT_GL(glEnableVertexAttribArray(kPositionSlot));
+    ASSERT_GL(glEnableVertexAttribArray(kTexCoordSlot));
+    ASSERT_GL(glVertexAttribPointer(kPositionSlot,    3, GL_FLOAT, GL_FALSE, sizeof(kFullscreenVertices[0]), (void*)(ptr+=0)));
+    ASSERT_GL(glVertexAttribPointer(kTexCoordSlot,    2, GL_FLOAT, GL_FALSE, sizeof(kFullscreenVertices[0]), (void*)(ptr+=3)));
     ASSERT_GL(glBindBuffer(GL_ARRAY_BUFFER, 0));
 
     /* Create index buffer */
     ASSERT_GL(glGenBuffers(1, &G->fullscreen_quad_index_buffer));
     ASSERT_GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, G->fullscreen_quad_index_buffer));
     ASSERT_GL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(kFullscreenIndices), kFullscreenIndices, GL_STATIC_DRAW));
-    ASSERT_GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+    ASSERT_GL(glBindVertexArray(0));
 }
 static void _draw_fullscreen_quad(Graphics* G)
 {
-    float* ptr = 0;
-    ASSERT_GL(glBindBuffer(GL_ARRAY_BUFFER, G->fullscreen_quad_vertex_buffer));
-    ASSERT_GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, G->fullscreen_quad_index_buffer));
-    ASSERT_GL(glVertexAttribPointer(kPositionSlot,    3, GL_FLOAT, GL_FALSE, sizeof(kFullscreenVertices[0]), (void*)(ptr+=0)));
-    ASSERT_GL(glVertexAttribPointer(kTexCoordSlot,    2, GL_FLOAT, GL_FALSE, sizeof(kFullscreenVertices[0]), (void*)(ptr+=3)));
+    ASSERT_GL(glBindVertexArray(G->fullscreen_quad_vertex_array));
     ASSERT_GL(glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, NULL));
 }
 static void _create_framebuffer(Graphics* G)
@@ -179,6 +224,188 @@ static void _resize_framebuffer(Graphics* G)
     ASSERT_GL(glBindTexture(GL_TEXTURE_2D, 0));
 }
 
+static void _update_frustum(Graphics* G)
+{
+    G->frustum = frustum_from_matrix(mat4_multiply(G->view_matrix, G->proj_matrix));
+}
+/** Projects a view space bounding sphere to pick the mesh's level of detail
+ */
+static int _select_mesh_lod(const Graphics* G, const Mesh* mesh, Vec3 view_center, float view_radius)
+{
+    /* Anything reaching the near plane gets the full detail */
+    if(mesh == NULL || view_center.z - view_radius <= kNearPlane)
+        return 0;
+    return select_mesh_lod(mesh, view_radius*G->proj_matrix.r1.y*G->height*0.5f/view_center.z);
+}
+
+/** @return The capacity a full frame list grows to. An empty one starts at
+ *      last frame's size, so a steady scene allocates it once
+ */
+static int _grow_list_capacity(int capacity, int prev_count)
+{
+    int new_capacity = capacity ? capacity*2 : prev_count;
+    return new_capacity < kMinListSize ? kMinListSize : new_capacity;
+}
+static void _reserve_render_items(Graphics* G, int count)
+{
+    size_t capacity = (size_t)G->max_render_items;
+    if(count <= G->max_render_items)
+        return;
+    do {
+        G->max_render_items = _grow_list_capacity(G->max_render_items, G->prev_num_render_items);
+    } while(G->max_render_items < count);
+    G->render_items = (RenderItem*)reallocate_frame_memory(G->frame_arena, G->render_items,
+                                                           capacity*sizeof(RenderItem),
+                                                           (size_t)G->max_render_items*sizeof(RenderItem));
+}
+/** @return The point moved from model to world space, as the transform's
+ *      matrix would
+ */
+static Vec3 _transform_point(const Transform* transform, Vec3 point)
+{
+    Vec3 axis = vec3_create(transform->orientation.x, transform->orientation.y, transform->orientation.z);
+    Vec3 t;
+    point = vec3_mul_scalar(point, transform->scale);
+    t = vec3_mul_scalar(vec3_cross(axis, point), 2.0f);
+    point = vec3_add(point, vec3_mul_scalar(t, transform->orientation.w));
+    point = vec3_add(point, vec3_cross(axis, t));
+    return vec3_add(point, transform->position);
+}
+/** @return A 16 bit id for a material or mesh. Different resources can
+ *      share an id, which only costs some state changes
+ */
+static uint32_t _get_sort_id(const void* resource)
+{
+    return ((uint32_t)((uintptr_t)resource >> 4) * 2654435761u) >> 16;
+}
+/** @return The view depth mapped to 24 bits between the near and far planes
+ */
+static uint32_t _quantize_depth(float depth)
+{
+    float t = (depth - kNearPlane)/(kFarPlane - kNearPlane);
+    if(t < 0.0f)
+        t = 0.0f;
+    else if(t > 1.0f)
+        t = 1.0f;
+    return (uint32_t)(t * 0xFFFFFF);
+}
+/** Builds a pass's key from an item's. From the top bit: 2 bits of pass,
+ *  then the item's 24 bit depth and 16 bit material and mesh ids in the
+ *  order the mode wants
+ */
+static uint64_t _get_pass_sort_key(int pass, SortMode mode, uint64_t item_key)
+{
+    uint64_t key = (uint64_t)pass << 62;
+    uint64_t depth = item_key >> 32;
+    uint64_t material = (item_key >> 16) & 0xFFFF;
+    uint64_t mesh = item_key & 0xFFFF;
+    switch(mode) {
+    case kSortFrontToBack:
+        key |= depth << 38 | material << 22 | mesh << 6;
+        break;
+    case kSortMaterial:
+        key |= material << 46 | mesh << 30 | depth << 6;
+        break;
+    case kSortNone:
+    default:
+        break;
+    }
+    return key;
+}
+/** Computes the model's level of detail and sort key. This, the world
+ *  matrix batch and the renderers' draw loops are the only places models
+ *  are read
+ */
+static void _fill_render_item(Graphics* G, const Model* model, int index)
+{
+    RenderItem* item = &G->render_items[index];
+    Vec3 center = vec3_zero;
+    float radius = 0.0f;
+    Vec4 position;
+    Vec3 view_center;
+
+    if(model->mesh)
+        get_mesh_bounds(model->mesh, &center, &radius);
+    position = vec4_from_vec3(_transform_point(&model->transform, center), 1.0f);
+    position = mat4_mul_vector(position, G->view_matrix);
+    view_center = vec3_from_vec4(position);
+
+    item->model = model;
+    item->world_matrix = (uint32_t)index;
+    item->lod = _select_mesh_lod(G, model->mesh, view_center, radius*model->transform.scale);
+    item->sort_key = (uint64_t)_quantize_depth(view_center.z) << 32 |
+                     (uint64_t)_get_sort_id(model->material) << 16 |
+                     (uint64_t)_get_sort_id(model->mesh);
+}
+/** Converts every item's transform to a world matrix in one batch, for all
+ *  passes to share
+ */
+static void _compute_world_matrices(Graphics* G)
+{
+    int count = G->num_render_items;
+    const Transform** transforms = (const Transform**)allocate_frame_memory(G->frame_arena, (size_t)count*sizeof(*transforms));
+    int ii;
+    for(ii=0;ii<count;++ii)
+        transforms[ii] = &G->render_items[ii].model->transform;
+    G->world_matrices = (Mat4*)allocate_frame_memory(G->frame_arena, (size_t)count*sizeof(Mat4));
+    compute_world_matrices(G->world_matrices, transforms, count);
+}
+/** Drops the lights whose sphere misses the frustum or covers too few pixels
+ *  to matter, keeping the rest in submission order
+ *  @return The number of lights dropped
+ */
+static int _cull_lights(Graphics* G)
+{
+    float pixels_per_unit = G->proj_matrix.r1.y*G->height*0.5f;
+    int num_submitted = G->num_lights;
+    int num_visible = 0;
+    int ii;
+    for(ii=0;ii<num_submitted;++ii) {
+        const Light* light = &G->lights[ii];
+        Vec4 view_position;
+        if(!frustum_intersects_sphere(&G->frustum, light->position, light->size))
+            continue;
+        /* Anything reaching the near plane is big on screen */
+        view_position = mat4_mul_vector(vec4_from_vec3(light->position, 1.0f), G->view_matrix);
+        if(view_position.z - light->size > kNearPlane &&
+           light->size*pixels_per_unit < kMinLightPixels*view_position.z)
+            continue;
+        G->lights[num_visible++] = *light;
+    }
+    G->num_lights = num_visible;
+    return num_submitted - num_visible;
+}
+/** Sorts the frame's items once for each of the active renderer's passes
+ */
+static void _sort_render_items(Graphics* G, RenderQueue* queue)
+{
+    int num_passes = kRendererPasses[G->active_renderer];
+    const SortMode* modes = G->sort_modes[G->active_renderer];
+    int count = G->num_render_items;
+    size_t num_keys = (size_t)(num_passes*count);
+    uint64_t* keys = (uint64_t*)allocate_frame_memory(G->frame_arena, num_keys*sizeof(*keys));
+    uint64_t* temp_keys = (uint64_t*)allocate_frame_memory(G->frame_arena, num_keys*sizeof(*temp_keys));
+    uint32_t* order = (uint32_t*)allocate_frame_memory(G->frame_arena, num_keys*sizeof(*order));
+    uint32_t* temp_order = (uint32_t*)allocate_frame_memory(G->frame_arena, num_keys*sizeof(*temp_order));
+    int pass, ii;
+
+    for(pass=0;pass<num_passes;++pass) {
+        uint64_t* pass_keys = keys + pass*count;
+        uint32_t* pass_order = order + pass*count;
+        for(ii=0;ii<count;++ii) {
+            pass_keys[ii] = _get_pass_sort_key(pass, modes[pass], G->render_items[ii].sort_key);
+            pass_order[ii] = (uint32_t)ii;
+        }
+    }
+    radix_sort(keys, order, temp_keys, temp_order, num_keys);
+
+    queue->items = G->render_items;
+    queue->world_matrices = G->world_matrices;
+    queue->num_items = count;
+    for(pass=0;pass<MAX_RENDER_PASSES;++pass)
+        queue->order[pass] = order + (pass < num_passes ? pass : 0)*count;
+}
+
 /* External functions
  */
 Graphics* create_graphics(void)
@@ -218,6 +445,7 @@ Graphics* create_graphics(void)
     }
 
     /* Set up self */
+    G->frame_arena = create_frame_arena(kFrameArenaSize);
     _create_fullscreen_quad(G);
     _create_framebuffer(G);
 
@@ -232,6 +460,7 @@ Graphics* create_graphics(void)
     else
         G->active_renderer = kLightPrePass;
     G->static_size = 0;
+    memcpy(G->sort_modes, kDefaultSortModes, sizeof(G->sort_modes));
 
     return G;
 }
@@ -241,6 +470,7 @@ void destroy_graphics(Graphics* G)
     destroy_light_prepass_renderer(G->light_prepass);
     destroy_forward_renderer(G->forward);
     destroy_program(G->fullscreen_program);
+    destroy_frame_arena(G->frame_arena);
     free(G);
 }
 void resize_graphics(Graphics* G, int width, int height)
@@ -255,7 +485,8 @@ void resize_graphics(Graphics* G, int width, int height)
     G->real_width = width;
     G->real_height = height;
 
-    G->proj_matrix = mat4_perspective_fov(kPiDiv2, width/(float)height, 1.0f, 100.0f);
+    G->proj_matrix = mat4_perspective_fov(kPiDiv2, width/(float)height, kNearPlane, kFarPlane);
+    _update_frustum(G);
 
     ASSERT_GL(glGetIntegerv(GL_FRAMEBUFFER_BINDING, &G->default_framebuffer));
 
@@ -271,32 +502,50 @@ void resize_graphics(Graphics* G, int width, int height)
 }
 void render_graphics(Graphics* G)
 {
+    RenderQueue queue;
     GLint device_framebuffer;
+    int num_culled_lights;
     ASSERT_GL(glGetIntegerv(GL_FRAMEBUFFER_BINDING, &device_framebuffer));
 
+    num_culled_lights = _cull_lights(G);
+    _compute_world_matrices(G);
+    _sort_render_items(G, &queue);
+
     ASSERT_GL(glViewport(0, 0, G->width, G->height));
     /* Render scene */
     if(G->major_version >= 3 && G->deferred && G->active_renderer == kDeferred) {
         render_deferred(G->deferred, G->framebuffer,
                         G->proj_matrix, G->view_matrix,
-                        G->render_commands, G->num_render_commands,
+                        &queue,
                         G->lights, G->num_lights);
     } else if(G->active_renderer == kForward) {
         render_forward(G->forward, G->framebuffer,
                        G->proj_matrix, G->view_matrix,
-                       G->render_commands, G->num_render_commands,
+                       &queue,
                        G->lights, G->num_lights);
     } else if(G->active_renderer == kLightPrePass) {
         render_light_prepass(G->light_prepass, G->framebuffer,
                              G->proj_matrix, G->view_matrix,
-                             G->render_commands, G->num_render_commands,
+                             &queue,
                              G->lights, G->num_lights);
     } else {
         system_log("No Active Renderer");
         assert(0);
     }
-    G->num_render_commands = 0;
-    G->num_lights = 0;
+    /* The frame's items and lights are gone after this */
+    G->prev_num_render_items = G->num_render_items;
+    G->prev_num_lights = G->num_lights + num_culled_lights;
+    G->prev_num_visible_lights = G->num_lights;
+    G->prev_num_culled_lights = num_culled_lights;
+    G->prev_num_visible = G->num_visible;
+    G->prev_num_culled = G->num_culled;
+    G->num_visible = G->num_culled = 0;
+    G->render_items = NULL;
+    G->world_matrices = NULL;
+    G->lights = NULL;
+    G->num_render_items = G->max_render_items = 0;
+    G->num_lights = G->max_lights = 0;
+    reset_frame_arena(G->frame_arena);
 
     /* Bind default framebuffer and render to the screen */
     ASSERT_GL(glBindFramebuffer(GL_FRAMEBUFFER, device_framebuffer));
@@ -313,17 +562,57 @@ void render_graphics(Graphics* G)
 void set_view_matrix(Graphics* G, Mat4 view)
 {
     G->view_matrix = view;
+    _update_frustum(G);
 }
-void add_render_command(Graphics* G, Model model)
+void add_render_command(Graphics* G, const Model* model)
 {
-    int index = G->num_render_commands++;
-    assert(index <= MAX_RENDER_COMMANDS);
-    G->render_commands[index] = model;
+    add_render_commands(G, model, 1);
+}
+void add_render_commands(Graphics* G, const Model* models, int count)
+{
+    const Transform* transforms[CULL_BATCH_SIZE];
+    Vec3 centers[CULL_BATCH_SIZE];
+    Vec3 extents[CULL_BATCH_SIZE];
+    float radii[CULL_BATCH_SIZE];
+    int visible[CULL_BATCH_SIZE];
+    int first, ii;
+
+    /* Only the models inside the frustum become items */
+    for(first=0;first<count;first+=CULL_BATCH_SIZE) {
+        int batch = count - first < CULL_BATCH_SIZE ? count - first : CULL_BATCH_SIZE;
+        int base = G->num_render_items;
+        int num_visible;
+        for(ii=0;ii<batch;++ii) {
+            const Model* model = &models[first + ii];
+            transforms[ii] = &model->transform;
+            if(model->mesh) {
+                get_mesh_box(model->mesh, &centers[ii], &extents[ii]);
+                get_mesh_bounds(model->mesh, &centers[ii], &radii[ii]);
+            } else {
+                centers[ii] = extents[ii] = vec3_zero;
+                radii[ii] = 0.0f;
+            }
+        }
+        num_visible = cull_bounds(visible, &G->frustum, transforms, centers, extents, radii, batch);
+
+        _reserve_render_items(G, base + num_visible);
+        G->num_render_items += num_visible;
+        for(ii=0;ii<num_visible;++ii)
+            _fill_render_item(G, &models[first + visible[ii]], base + ii);
+        G->num_visible += num_visible;
+        G->num_culled += batch - num_visible;
+    }
 }
 void add_light(Graphics* G, Light light)
 {
     int index = G->num_lights++;
-    assert(index <= MAX_LIGHTS);
+    if(index == G->max_lights) {
+        size_t capacity = (size_t)G->max_lights;
+        G->max_lights = _grow_list_capacity(G->max_lights, G->prev_num_lights);
+        G->lights = (Light*)reallocate_frame_memory(G->frame_arena, G->lights,
+                                                    capacity*sizeof(Light),
+                                                    (size_t)G->max_lights*sizeof(Light));
+    }
     G->lights[index] = light;
 }
 RendererType renderer_type(const Graphics* G)
@@ -349,3 +638,23 @@ void toggle_static_size(Graphics* G)
     G->static_size = !G->static_size;
     resize_graphics(G, G->real_width, G->real_height);
 }
+size_t get_graphics_frame_memory(const Graphics* G)
+{
+    return get_frame_arena_high_water(G->frame_arena);
+}
+void get_graphics_cull_stats(const Graphics* G, int* visible, int* culled)
+{
+    *visible = G->prev_num_visible;
+    *culled = G->prev_num_culled;
+}
+void get_graphics_light_cull_stats(const Graphics* G, int* visible, int* culled)
+{
+    *visible = G->prev_num_visible_lights;
+    *culled = G->prev_num_culled_lights;
+}
+void set_pass_sort_mode(Graphics* G, RendererType renderer, int pass, SortMode mode)
+{
+    assert(renderer < MAX_RENDERERS);
+    assert(pass >= 0 && pass < kRendererPasses[renderer]);
+    G->sort_modes[renderer][pass] = mode;
+}
@@ -20,7 +20,7 @@
 #include "scene.h"
 #include "graphics_types.h"
 
-#define MAX_LIGHTS 128
+#define MAX_RENDER_PASSES 2 /* Passes over the models per renderer */
 
 typedef enum {
     kForward,
@@ -30,13 +30,48 @@ typedef enum {
     MAX_RENDERERS
 } RendererType;
 
+/** How a pass orders the models it draws
+ */
+typedef enum {
+    kSortNone,          /* Submission order */
+    kSortFrontToBack,   /* Nearest first, for early depth rejection */
+    kSortMaterial,      /* By material, then mesh, then nearest first */
+} SortMode;
+
+/** A model submitted for drawing, holding only what the frame needs
+ */
+typedef struct RenderItem
+{
+    uint64_t        sort_key;       /* View depth, material and mesh */
+    const Model*    model;
+    uint32_t        world_matrix;   /* Slot in RenderQueue::world_matrices */
+    int             lod;
+} RenderItem;
+
+/** The frame's items, with the order each of the renderer's passes draws
+ *  them in. `order[pass]` holds `num_items` indices into `items`
+ */
+typedef struct RenderQueue
+{
+    const RenderItem*   items;
+    const Mat4*         world_matrices;
+    const uint32_t*     order[MAX_RENDER_PASSES];
+    int                 num_items;
+} RenderQueue;
+
 Graphics* create_graphics(void);
 void destroy_graphics(Graphics* G);
 
 void resize_graphics(Graphics* G, int width, int height);
 
 void set_view_matrix(Graphics* G, Mat4 view);
-void add_render_command(Graphics* G, Model model);
+/** @brief Submits a model for this frame. The model is referenced, not
+ *      copied, so it must stay alive and unchanged until render_graphics.
+ *      Models outside the view frustum are dropped here, so set the view
+ *      matrix first
+ */
+void add_render_command(Graphics* G, const Model* model);
+void add_render_commands(Graphics* G, const Model* models, int count);
 void add_light(Graphics* G, Light light);
 
 void render_graphics(Graphics* G);
@@ -48,4 +83,22 @@ void graphics_size(const Graphics* G, int* width, int* height);
 
 void toggle_static_size(Graphics* G);
 
+/** @brief Sets how one of a renderer's passes orders its models. By default
+ *      depth-only and G-buffer passes go front to back, and shading passes
+ *      go by material
+ */
+void set_pass_sort_mode(Graphics* G, RendererType renderer, int pass, SortMode mode);
+
+/** @return The most memory, in bytes, one frame's render items, lights
+ *      and sorting have needed
+ */
+size_t get_graphics_frame_memory(const Graphics* G);
+/** @brief Render commands the last rendered frame drew and culled
+ */
+void get_graphics_cull_stats(const Graphics* G, int* visible, int* culled);
+/** @brief Lights the last rendered frame drew, and culled for missing the
+ *      view frustum or covering too few pixels
+ */
+void get_graphics_light_cull_stats(const Graphics* G, int* visible, int* culled);
+
 #endif /* include guard */
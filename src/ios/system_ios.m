@@ -17,6 +17,10 @@
 #import <Foundation/Foundation.h>
 #include <stdlib.h>
 #include "assert.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 /* Defines
  */
@@ -24,6 +28,11 @@
 
 /* Types
  */
+typedef struct MappedFile
+{
+    void*   address;
+    size_t  size;
+} MappedFile;
 
 /* Constants
  */
@@ -43,11 +52,14 @@ int load_file_data(const char* filename, void** data, size_t* data_size)
     NSString* adjusted_relative_path = [@"/assets/" stringByAppendingString:[NSString stringWithUTF8String:filename]];
     full_path = [[NSBundle mainBundle] pathForResource:adjusted_relative_path ofType:nil];
 
+    if(full_path == nil)
+        return -1;
     file = fopen([full_path UTF8String], "rb");
-    assert(file);
+    if(file == NULL)
+        return -1;
 
     fseek(file, 0, SEEK_END);
-    *data_size = ftell(file);
+    *data_size = (size_t)ftell(file);
     fseek(file, 0, SEEK_SET);
 
     *data = calloc(1,*data_size);
@@ -63,6 +75,92 @@ void free_file_data(void* data)
 {
     free(data);
 }
+static const char* _asset_path(const char* filename)
+{
+    NSString* adjusted_relative_path = [@"/assets/" stringByAppendingString:[NSString stringWithUTF8String:filename]];
+    NSString* full_path = [[NSBundle mainBundle] pathForResource:adjusted_relative_path ofType:nil];
+    return [full_path UTF8String];
+}
+int map_file_data(const char* filename, const void** data, size_t* data_size, void** handle)
+{
+    MappedFile* mapped = NULL;
+    struct stat file_stat;
+    void*       address;
+    int         file = open(_asset_path(filename), O_RDONLY);
+    if(file < 0)
+        return -1;
+    if(fstat(file, &file_stat) != 0 || file_stat.st_size == 0) {
+        close(file);
+        return -1;
+    }
+    address = mmap(NULL, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if(address == MAP_FAILED)
+        return -1;
+
+    mapped = (MappedFile*)calloc(1, sizeof(MappedFile));
+    mapped->address = address;
+    mapped->size = (size_t)file_stat.st_size;
+    *data = address;
+    *data_size = mapped->size;
+    *handle = mapped;
+    return 0;
+}
+void unmap_file_data(void* handle)
+{
+    MappedFile* mapped = (MappedFile*)handle;
+    munmap(mapped->address, mapped->size);
+    free(mapped);
+}
+FileStream* open_file_stream(const char* filename)
+{
+    return (FileStream*)fopen(_asset_path(filename), "rb");
+}
+size_t read_file_stream(FileStream* stream, void* buffer, size_t size)
+{
+    return fread(buffer, 1, size, (FILE*)stream);
+}
+void close_file_stream(FileStream* stream)
+{
+    fclose((FILE*)stream);
+}
+static const char* _cache_path(const char* filename)
+{
+    NSString* cache_directory = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) objectAtIndex:0];
+    NSString* full_path = [cache_directory stringByAppendingPathComponent:[NSString stringWithUTF8String:filename]];
+    return [full_path UTF8String];
+}
+int load_cache_data(const char* filename, void** data, size_t* data_size)
+{
+    FILE*   file = fopen(_cache_path(filename), "rb");
+    long    file_size;
+    if(file == NULL)
+        return -1;
+
+    fseek(file, 0, SEEK_END);
+    file_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    *data = malloc((size_t)file_size);
+    *data_size = (size_t)file_size;
+    if(*data == NULL || fread(*data, (size_t)file_size, 1, file) != 1) {
+        free(*data);
+        fclose(file);
+        return -1;
+    }
+    fclose(file);
+    return 0;
+}
+int save_cache_data(const char* filename, const void* data, size_t data_size)
+{
+    FILE*   file = fopen(_cache_path(filename), "wb");
+    size_t  written;
+    if(file == NULL)
+        return -1;
+    written = fwrite(data, data_size, 1, file);
+    fclose(file);
+    return written == 1 ? 0 : -1;
+}
 void system_log(const char* format, ...)
 {
     va_list args;
@@ -37,6 +37,7 @@ struct LightPrepassRenderer
 
     GLuint  cube_vertex_buffer;
     GLuint  cube_index_buffer;
+    GLuint  cube_vertex_array;
 
     GLuint  gbuffer_framebuffer;
     GLuint  gbuffer_color_texture;
@@ -92,6 +93,18 @@ struct LightPrepassRenderer
 
 /* Constants
  */
+static const char* kPass1VertexShaders[kNumVertexFormats] =
+{
+    "shaders/light_prepass/Pass1Vertex.glsl",           /* kVertexFormatFloat */
+    "shaders/light_prepass/Pass1QTangentVertex.glsl",   /* kVertexFormatQTangent */
+    "shaders/light_prepass/Pass1CompressedVertex.glsl", /* kVertexFormatCompressed */
+};
+static const char* kPass3VertexShaders[kNumVertexFormats] =
+{
+    "shaders/light_prepass/Pass3Vertex.glsl",           /* kVertexFormatFloat */
+    "shaders/light_prepass/Pass3Vertex.glsl",           /* kVertexFormatQTangent */
+    "shaders/light_prepass/Pass3CompressedVertex.glsl", /* kVertexFormatCompressed */
+};
  /* cube vertices
  *
  *               5---------4
@@ -141,9 +154,7 @@ static const uint16_t kCubeIndices[] =
  */
 static void _draw_point_light(LightPrepassRenderer* R)
 {
-    ASSERT_GL(glBindBuffer(GL_ARRAY_BUFFER, R->cube_vertex_buffer));
-    ASSERT_GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, R->cube_index_buffer));
-    ASSERT_GL(glVertexAttribPointer(kPositionSlot, 3, GL_FLOAT, GL_FALSE, sizeof(Vec3), (void*)0));
+    ASSERT_GL(glBindVertexArray(R->cube_vertex_array));
     ASSERT_GL(glDrawElements(GL_TRIANGLES, sizeof(kCubeIndices)/sizeof(kCubeIndices[0]), GL_UNSIGNED_SHORT, NULL));
 }
 
@@ -151,39 +162,34 @@ static void _draw_point_light(LightPrepassRenderer* R)
  */
 LightPrepassRenderer* create_light_prepass_renderer(Graphics* G, int major_version, int minor_version)
 {
-    AttributeSlot pass1_slots[] = {
-        kPositionSlot,
-        kNormalSlot,
-        kTangentSlot,
-        kBitangentSlot,
-        kTexCoordSlot,
-        kEmptySlot
-    };
+    const AttributeSlot* pass1_slots = get_mesh_attribute_slots();
     AttributeSlot pass2_slots[] = {
         kPositionSlot,
         kEmptySlot
     };
-    AttributeSlot pass3_slots[] = {
-        kPositionSlot,
-        kTexCoordSlot,
-        kEmptySlot
-    };
+    const AttributeSlot* pass3_slots = get_mesh_attribute_slots();
 
     LightPrepassRenderer* R = (LightPrepassRenderer*)calloc(1,sizeof(*R));
     R->major_version = major_version;
     R->minor_version = minor_version;
 
+    /* Create vertex array */
+    ASSERT_GL(glGenVertexArrays(1, &R->cube_vertex_array));
+    ASSERT_GL(glBindVertexArray(R->cube_vertex_array));
+
     /* Create vertex buffer */
     ASSERT_GL(glGenBuffers(1, &R->cube_vertex_buffer));
     ASSERT_GL(glBindBuffer(GL_ARRAY_BUFFER, R->cube_vertex_buffer));
     ASSERT_GL(glBufferData(GL_ARRAY_BUFFER, sizeof(kCubeVertices), kCubeVertices, GL_STATIC_DRAW));
+    ASSERT_GL(glEnableVertexAttribArray(kPositionSlot));
+    ASSERT_GL(glVertexAttribPointer(kPositionSlot, 3, GL_FLOAT, GL_FALSE, sizeof(Vec3), (void*)0));
     ASSERT_GL(glBindBuffer(GL_ARRAY_BUFFER, 0));
 
     /* Create index buffer */
     ASSERT_GL(glGenBuffers(1, &R->cube_index_buffer));
     ASSERT_GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, R->cube_index_buffer));
     ASSERT_GL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(kCubeIndices), kCubeIndices, GL_STATIC_DRAW));
-    ASSERT_GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+    ASSERT_GL(glBindVertexArray(0));
 
     /* Create framebuffer */
     ASSERT_GL(glGenFramebuffers(1, &R->gbuffer_framebuffer));
@@ -217,7 +223,7 @@ LightPrepassRenderer* create_light_prepass_renderer(Graphics* G, int major_versi
 
     /** Pass 1
      */
-    R->pass1.program = create_program("shaders/light_prepass/Pass1Vertex.glsl", "shaders/light_prepass/Pass1Fragment.glsl", pass1_slots);
+    R->pass1.program = create_program(kPass1VertexShaders[get_vertex_format()], "shaders/light_prepass/Pass1Fragment.glsl", pass1_slots);
 
     ASSERT_GL(GetUniformLocation(R, pass1, program, u_Projection));
     ASSERT_GL(GetUniformLocation(R, pass1, program, u_View));
@@ -228,13 +234,6 @@ LightPrepassRenderer* create_light_prepass_renderer(Graphics* G, int major_versi
     ASSERT_GL(GetUniformLocation(R, pass1, program, s_Normal));
 
     ASSERT_GL(glUseProgram(R->pass1.program));
-
-    ASSERT_GL(glEnableVertexAttribArray(kPositionSlot));
-    ASSERT_GL(glEnableVertexAttribArray(kNormalSlot));
-    ASSERT_GL(glEnableVertexAttribArray(kTangentSlot));
-    ASSERT_GL(glEnableVertexAttribArray(kBitangentSlot));
-    ASSERT_GL(glEnableVertexAttribArray(kTexCoordSlot));
-
     ASSERT_GL(glUniform1i(R->pass1.s_Normal, 0));
     ASSERT_GL(glUseProgram(0));
 
@@ -258,16 +257,13 @@ LightPrepassRenderer* create_light_prepass_renderer(Graphics* G, int major_versi
     ASSERT_GL(GetUniformLocation(R, pass2, program, u_LightSize));
 
     ASSERT_GL(glUseProgram(R->pass2.program));
-
-    ASSERT_GL(glEnableVertexAttribArray(kPositionSlot));
-
     ASSERT_GL(glUniform1i(R->pass2.s_GBuffer, 0));
     ASSERT_GL(glUniform1i(R->pass2.s_Depth, 1));
     ASSERT_GL(glUseProgram(0));
 
     /** Pass 3
      */
-    R->pass3.program = create_program("shaders/light_prepass/Pass3Vertex.glsl", "shaders/light_prepass/Pass3Fragment.glsl", pass3_slots);
+    R->pass3.program = create_program(kPass3VertexShaders[get_vertex_format()], "shaders/light_prepass/Pass3Fragment.glsl", pass3_slots);
 
     ASSERT_GL(GetUniformLocation(R, pass3, program, u_Projection));
     ASSERT_GL(GetUniformLocation(R, pass3, program, u_View));
@@ -279,11 +275,6 @@ LightPrepassRenderer* create_light_prepass_renderer(Graphics* G, int major_versi
     ASSERT_GL(GetUniformLocation(R, pass3, program, s_Albedo));
 
     ASSERT_GL(glUseProgram(R->pass3.program));
-
-    ASSERT_GL(glEnableVertexAttribArray(kPositionSlot));
-    ASSERT_GL(glEnableVertexAttribArray(kTexCoordSlot));
-
-
     ASSERT_GL(glUniform1i(R->pass3.s_GBuffer, 0));
     ASSERT_GL(glUniform1i(R->pass3.s_Albedo, 1));
     ASSERT_GL(glUseProgram(0));
@@ -335,11 +326,12 @@ void resize_light_prepass_renderer(LightPrepassRenderer* R, int width, int heigh
 
 void render_light_prepass(LightPrepassRenderer* R, GLuint default_framebuffer,
                           Mat4 proj_matrix, Mat4 view_matrix,
-                          const Model* models, int num_models,
+                          const RenderQueue* queue,
                           const Light* lights, int num_lights)
 {
     Mat4 inv_proj = mat4_inverse(proj_matrix);
     float viewport[] = { R->width, R->height };
+    const Material* material = NULL;
     int ii;
 
     /** Pass 1
@@ -357,15 +349,21 @@ void render_light_prepass(LightPrepassRenderer* R, GLuint default_framebuffer,
     ASSERT_GL(glUniformMatrix4fv(R->pass1.u_Projection, 1, GL_FALSE, (float*)&proj_matrix));
     ASSERT_GL(glUniformMatrix4fv(R->pass1.u_View, 1, GL_FALSE, (float*)&view_matrix));
 
-    for(ii=0;ii<num_models;++ii) {
-        Mat4 world_matrix = transform_get_matrix(models[ii].transform);
-        /* Material */
-        ASSERT_GL(glUniform1f(R->pass1.u_SpecularPower, models[ii].material->specular_power));
-        ASSERT_GL(glActiveTexture(GL_TEXTURE0));
-        ASSERT_GL(glBindTexture(GL_TEXTURE_2D, models[ii].material->normal));
+    begin_mesh_draws();
+    for(ii=0;ii<queue->num_items;++ii) {
+        const RenderItem* item = &queue->items[queue->order[0][ii]];
+        const Model* model = item->model;
+        const Mat4* world_matrix = &queue->world_matrices[item->world_matrix];
+        /* Material, only when it changes */
+        if(model->material != material) {
+            material = model->material;
+            ASSERT_GL(glUniform1f(R->pass1.u_SpecularPower, material->specular_power));
+            ASSERT_GL(glActiveTexture(GL_TEXTURE0));
+            ASSERT_GL(glBindTexture(GL_TEXTURE_2D, material->normal));
+        }
         /* Mesh */
-        ASSERT_GL(glUniformMatrix4fv(R->pass1.u_World, 1, GL_FALSE, (float*)&world_matrix));
-        draw_mesh(models[ii].mesh);
+        ASSERT_GL(glUniformMatrix4fv(R->pass1.u_World, 1, GL_FALSE, (const float*)world_matrix));
+        draw_mesh(model->mesh, item->lod);
     }
 
     /** Pass 2
@@ -428,14 +426,21 @@ void render_light_prepass(LightPrepassRenderer* R, GLuint default_framebuffer,
     ASSERT_GL(glActiveTexture(GL_TEXTURE0));
     ASSERT_GL(glBindTexture(GL_TEXTURE_2D, R->lighting_buffer));
 
-    for(ii=0;ii<num_models;++ii) {
-        Mat4 world_matrix = transform_get_matrix(models[ii].transform);
-        /* Material */
-        ASSERT_GL(glActiveTexture(GL_TEXTURE1));
-        ASSERT_GL(glBindTexture(GL_TEXTURE_2D, models[ii].material->albedo));
+    begin_mesh_draws();
+    material = NULL;
+    for(ii=0;ii<queue->num_items;++ii) {
+        const RenderItem* item = &queue->items[queue->order[1][ii]];
+        const Model* model = item->model;
+        const Mat4* world_matrix = &queue->world_matrices[item->world_matrix];
+        /* Material, only when it changes */
+        if(model->material != material) {
+            material = model->material;
+            ASSERT_GL(glActiveTexture(GL_TEXTURE1));
+            ASSERT_GL(glBindTexture(GL_TEXTURE_2D, material->albedo));
+        }
         /* Mesh */
-        ASSERT_GL(glUniformMatrix4fv(R->pass3.u_World, 1, GL_FALSE, (float*)&world_matrix));
-        draw_mesh(models[ii].mesh);
+        ASSERT_GL(glUniformMatrix4fv(R->pass3.u_World, 1, GL_FALSE, (const float*)world_matrix));
+        draw_mesh(model->mesh, item->lod);
     }
     
     ASSERT_GL(glDepthMask(GL_TRUE));
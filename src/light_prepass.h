@@ -30,7 +30,7 @@ void resize_light_prepass_renderer(LightPrepassRenderer* R, int width, int heigh
 
 void render_light_prepass(LightPrepassRenderer* R, GLuint default_framebuffer,
                           Mat4 proj_matrix, Mat4 view_matrix,
-                          const Model* models, int num_models,
+                          const RenderQueue* queue,
                           const Light* lights, int num_lights);
 
 #endif /* include guard */
@@ -19,6 +19,10 @@
 #include <stdlib.h>
 #include <stdarg.h>
 #include "assert.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 /* Defines
  */
@@ -26,6 +30,11 @@
 
 /* Types
  */
+typedef struct MappedFile
+{
+    void*   address;
+    size_t  size;
+} MappedFile;
 
 /* Constants
  */
@@ -41,10 +50,11 @@
 int load_file_data(const char* filename, void** data, size_t* data_size)
 {
     FILE*   file = fopen(filename, "rb");
-    assert(file);
+    if(file == NULL)
+        return -1;
 
     fseek(file, 0, SEEK_END);
-    *data_size = ftell(file);
+    *data_size = (size_t)ftell(file);
     fseek(file, 0, SEEK_SET);
 
     *data = malloc(*data_size);
@@ -60,6 +70,80 @@ void free_file_data(void* data)
 {
     free(data);
 }
+int map_file_data(const char* filename, const void** data, size_t* data_size, void** handle)
+{
+    MappedFile* mapped = NULL;
+    struct stat file_stat;
+    void*       address;
+    int         file = open(filename, O_RDONLY);
+    if(file < 0)
+        return -1;
+    if(fstat(file, &file_stat) != 0 || file_stat.st_size == 0) {
+        close(file);
+        return -1;
+    }
+    address = mmap(NULL, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if(address == MAP_FAILED)
+        return -1;
+
+    mapped = (MappedFile*)calloc(1, sizeof(MappedFile));
+    mapped->address = address;
+    mapped->size = (size_t)file_stat.st_size;
+    *data = address;
+    *data_size = mapped->size;
+    *handle = mapped;
+    return 0;
+}
+void unmap_file_data(void* handle)
+{
+    MappedFile* mapped = (MappedFile*)handle;
+    munmap(mapped->address, mapped->size);
+    free(mapped);
+}
+FileStream* open_file_stream(const char* filename)
+{
+    return (FileStream*)fopen(filename, "rb");
+}
+size_t read_file_stream(FileStream* stream, void* buffer, size_t size)
+{
+    return fread(buffer, 1, size, (FILE*)stream);
+}
+void close_file_stream(FileStream* stream)
+{
+    fclose((FILE*)stream);
+}
+int load_cache_data(const char* filename, void** data, size_t* data_size)
+{
+    FILE*   file = fopen(filename, "rb");
+    long    file_size;
+    if(file == NULL)
+        return -1;
+
+    fseek(file, 0, SEEK_END);
+    file_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    *data = malloc((size_t)file_size);
+    *data_size = (size_t)file_size;
+    if(*data == NULL || fread(*data, (size_t)file_size, 1, file) != 1) {
+        free(*data);
+        fclose(file);
+        return -1;
+    }
+    fclose(file);
+    return 0;
+}
+int save_cache_data(const char* filename, const void* data, size_t data_size)
+{
+    FILE*   file = fopen(filename, "wb");
+    size_t  written;
+    if(file == NULL)
+        return -1;
+    written = fwrite(data, data_size, 1, file);
+    fclose(file);
+    return written == 1 ? 0 : -1;
+}
 void system_log(const char* format, ...)
 {
     va_list args;
@@ -16,6 +16,7 @@
 
 #include "mesh.h"
 #include <stdlib.h>
+#include <assert.h>
 #include "gl_include.h"
 
 /* Defines
@@ -23,67 +24,553 @@
 
 /* Types
  */
-struct Mesh
+/** Triangles drawn from one base vertex. Meshes whose indices span more
+ *  than 16 bits are split into several ranges so each can still use
+ *  16 bit indices relative to its base vertex. Both are in the elements of
+ *  the arena's buffers
+ */
+typedef struct MeshRange
+{
+    uint32_t    first_index;
+    uint32_t    index_count;
+    uint32_t    base_vertex;
+    int         window;     /* The arena window starting at base_vertex */
+} MeshRange;
+
+/** A level of detail and the ranges drawing it */
+typedef struct MeshLodRanges
+{
+    int         first_range;
+    int         num_ranges;
+    float       error;
+} MeshLodRanges;
+
+/** A base vertex of the arena, and the vertex array object reading from it.
+ *  The vertex array is created on first use
+ */
+typedef struct ArenaWindow
+{
+    uint32_t    base_vertex;
+    GLuint      vertex_array;
+} ArenaWindow;
+
+/** Vertex and index buffers shared by many meshes. OpenGL ES 3.0 can't
+ *  offset indices by a base vertex, so the vertex pointers are offset
+ *  instead. Meshes are packed into 16 bit windows of the vertex buffer that
+ *  share one base vertex, and so one vertex array object
+ */
+struct GeometryArena
 {
     GLuint      vertex_buffer;
     GLuint      index_buffer;
+    VertexFormat vertex_format;
+    size_t      vertex_count;
+    size_t      vertex_buffer_size;
+    size_t      index_bytes;
+    size_t      index_buffer_size;
+    uint32_t    window_base;
+    ArenaWindow* windows;
+    int         num_windows;
+};
+
+struct Mesh
+{
+    GeometryArena* arena;
     int         index_count;
+    VertexFormat vertex_format;
+    PositionQuantization quantization;
+    GLenum      index_type;
+    MeshRange*  ranges;
+    int         num_ranges;
+    MeshLodRanges lods[MAX_MESH_LODS];
+    int         num_lods;
+    Vec3        bounds_center;
+    Vec3        bounds_extents;
+    float       bounds_radius;
+    size_t      index_bytes_saved;
 };
 
 /* Constants
  */
+static const uint32_t kMaxShortIndexSpan = 0xFFFF;
+static const float kLodPixelError = 1.0f;
+
+/* Attributes bound by each format's shaders. Arrays come first, then the
+ * constants draw_mesh sets with glVertexAttrib */
+static const AttributeSlot kMeshAttributeSlots[kNumVertexFormats][7] =
+{
+    /* kVertexFormatFloat */
+    { kPositionSlot, kNormalSlot, kTangentSlot, kBitangentSlot, kTexCoordSlot, kEmptySlot },
+    /* kVertexFormatQTangent */
+    { kPositionSlot, kQTangentSlot, kTexCoordSlot, kEmptySlot },
+    /* kVertexFormatCompressed */
+    { kPositionSlot, kNormalSlot, kTangentSlot, kTexCoordSlot, kPositionScaleSlot, kPositionBiasSlot, kEmptySlot },
+};
 
 /* Variables
  */
+static VertexFormat _vertex_format = kVertexFormatFloat;
+/* What the last draw_mesh left bound */
+static GLuint _bound_vertex_array = 0;
 
 /* Internal functions
  */
+/** Converts `count` vertices, through the float Vertex layout when neither
+ *  side is float
+ */
+static void* _convert_vertices(const void* src, VertexFormat src_format, const PositionQuantization* src_quantization,
+                               size_t count, VertexFormat dest_format, PositionQuantization* dest_quantization)
+{
+    void* dest = malloc(count*get_vertex_size(dest_format));
+    Vertex* vertices = (Vertex*)src;
+
+    /* Decode */
+    if(src_format != kVertexFormatFloat) {
+        vertices = dest_format == kVertexFormatFloat ? (Vertex*)dest : (Vertex*)malloc(count*sizeof(Vertex));
+        if(src_format == kVertexFormatQTangent)
+            unpack_qtangent_vertices(vertices, (const QTangentVertex*)src, count);
+        else
+            decompress_vertices(vertices, (const CompressedVertex*)src, count, src_quantization);
+    }
+
+    /* Encode */
+    if(dest_format == kVertexFormatQTangent) {
+        pack_qtangent_vertices((QTangentVertex*)dest, vertices, count);
+    } else if(dest_format == kVertexFormatCompressed) {
+        *dest_quantization = get_position_quantization(vertices, count);
+        compress_vertices((CompressedVertex*)dest, vertices, count, dest_quantization);
+    }
+    if(vertices != src && vertices != dest)
+        free(vertices);
+    return dest;
+}
+
+/** Splits the triangles into ranges whose indices span at most
+ *  kMaxShortIndexSpan. Triangles keep their order
+ *  @return The number of ranges, or 0 if a single triangle spans too much
+ */
+static int _split_index_ranges(const uint32_t* indices, uint32_t index_count, MeshRange** ranges)
+{
+    int num_ranges = 0;
+    int capacity = 0;
+    uint32_t min = 0, max = 0;
+    uint32_t ii, jj;
+
+    *ranges = NULL;
+    for(ii=0; ii+3<=index_count; ii+=3) {
+        uint32_t tri_min = indices[ii], tri_max = indices[ii];
+        for(jj=1;jj<3;++jj) {
+            tri_min = indices[ii+jj] < tri_min ? indices[ii+jj] : tri_min;
+            tri_max = indices[ii+jj] > tri_max ? indices[ii+jj] : tri_max;
+        }
+        if(tri_max - tri_min > kMaxShortIndexSpan) {
+            free(*ranges);
+            *ranges = NULL;
+            return 0;
+        }
+        if(num_ranges) {
+            uint32_t new_min = tri_min < min ? tri_min : min;
+            uint32_t new_max = tri_max > max ? tri_max : max;
+            if(new_max - new_min <= kMaxShortIndexSpan) {
+                min = new_min;
+                max = new_max;
+                (*ranges)[num_ranges-1].index_count += 3;
+                (*ranges)[num_ranges-1].base_vertex = min;
+                continue;
+            }
+        }
+        /* Start a new range */
+        if(num_ranges == capacity) {
+            capacity = capacity ? capacity*2 : 1;
+            *ranges = (MeshRange*)realloc(*ranges, (size_t)capacity*sizeof(MeshRange));
+        }
+        (*ranges)[num_ranges].first_index = ii;
+        (*ranges)[num_ranges].index_count = 3;
+        (*ranges)[num_ranges].base_vertex = tri_min;
+        min = tri_min;
+        max = tri_max;
+        ++num_ranges;
+    }
+    return num_ranges;
+}
+/** Grows `*buffer` to hold at least `size` bytes, keeping the first `used`
+ *  @return 1 if the buffer was replaced
+ */
+static int _reserve_buffer(GLuint* buffer, size_t used, size_t* capacity, size_t size)
+{
+    GLuint new_buffer = 0;
+    if(size <= *capacity)
+        return 0;
+    if(size < *capacity*2)
+        size = *capacity*2;
+    ASSERT_GL(glGenBuffers(1, &new_buffer));
+    ASSERT_GL(glBindBuffer(GL_COPY_WRITE_BUFFER, new_buffer));
+    ASSERT_GL(glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)size, NULL, GL_STATIC_DRAW));
+    if(used) {
+        ASSERT_GL(glBindBuffer(GL_COPY_READ_BUFFER, *buffer));
+        ASSERT_GL(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, (GLsizeiptr)used));
+        ASSERT_GL(glBindBuffer(GL_COPY_READ_BUFFER, 0));
+    }
+    ASSERT_GL(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+    if(*buffer)
+        ASSERT_GL(glDeleteBuffers(1, buffer));
+    *buffer = new_buffer;
+    *capacity = size;
+    return 1;
+}
+/** Deletes the vertex arrays of the arena, as they refer to its old buffers */
+static void _release_vertex_arrays(GeometryArena* A)
+{
+    int ii;
+    for(ii=0;ii<A->num_windows;++ii) {
+        if(A->windows[ii].vertex_array == 0)
+            continue;
+        if(A->windows[ii].vertex_array == _bound_vertex_array) {
+            ASSERT_GL(glBindVertexArray(0));
+            _bound_vertex_array = 0;
+        }
+        ASSERT_GL(glDeleteVertexArrays(1, &A->windows[ii].vertex_array));
+        A->windows[ii].vertex_array = 0;
+    }
+}
+/** @return The window starting at `base_vertex`, added if it's new */
+static int _find_window(GeometryArena* A, uint32_t base_vertex)
+{
+    int ii;
+    for(ii=A->num_windows-1; ii>=0; --ii) {
+        if(A->windows[ii].base_vertex == base_vertex)
+            return ii;
+    }
+    A->windows = (ArenaWindow*)realloc(A->windows, (size_t)(A->num_windows+1)*sizeof(ArenaWindow));
+    A->windows[A->num_windows].base_vertex = base_vertex;
+    A->windows[A->num_windows].vertex_array = 0;
+    return A->num_windows++;
+}
+/** Appends `size` bytes to the arena's index buffer, aligned for 32 bit
+ *  indices
+ *  @return The byte offset of the data
+ */
+static size_t _append_indices(GeometryArena* A, const void* data, size_t size)
+{
+    size_t offset = (A->index_bytes + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1);
+    if(_reserve_buffer(&A->index_buffer, A->index_bytes, &A->index_buffer_size, offset + size))
+        _release_vertex_arrays(A);
+    ASSERT_GL(glBindBuffer(GL_COPY_WRITE_BUFFER, A->index_buffer));
+    ASSERT_GL(glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)offset, (GLsizeiptr)size, data));
+    ASSERT_GL(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+    A->index_bytes = offset + size;
+    return offset;
+}
+/** Splits every level of detail into ranges, appending them to `M->ranges`
+ *  @return 0 if a level can't use 16 bit indices
+ */
+static int _split_lod_ranges(Mesh* M, const uint32_t* indices, const MeshLod* lods, int num_lods)
+{
+    int ii, jj;
+    for(ii=0;ii<num_lods;++ii) {
+        MeshRange* ranges = NULL;
+        int num_ranges = _split_index_ranges(indices + lods[ii].first_index, lods[ii].index_count, &ranges);
+        if(num_ranges == 0) {
+            free(M->ranges);
+            M->ranges = NULL;
+            M->num_ranges = 0;
+            return 0;
+        }
+        M->ranges = (MeshRange*)realloc(M->ranges, (size_t)(M->num_ranges + num_ranges)*sizeof(MeshRange));
+        for(jj=0;jj<num_ranges;++jj) {
+            ranges[jj].first_index += lods[ii].first_index;
+            M->ranges[M->num_ranges + jj] = ranges[jj];
+        }
+        M->lods[ii].first_range = M->num_ranges;
+        M->lods[ii].num_ranges = num_ranges;
+        M->num_ranges += num_ranges;
+        free(ranges);
+    }
+    return 1;
+}
+static Vec3 _get_vertex_position(const void* vertex_data, size_t index, VertexFormat vertex_format,
+                                 const PositionQuantization* quantization)
+{
+    const char* vertex = (const char*)vertex_data + index*get_vertex_size(vertex_format);
+    if(vertex_format == kVertexFormatCompressed) {
+        const uint16_t* position = ((const CompressedVertex*)vertex)->position;
+        Vec3 normalized = {position[0]/65535.0f, position[1]/65535.0f, position[2]/65535.0f};
+        return vec3_add(vec3_mul(normalized, quantization->scale), quantization->bias);
+    }
+    /* The float and QTangent layouts start with the position */
+    return *(const Vec3*)vertex;
+}
+/** Bounds the positions with their box, and with the sphere around the box
+ *  center reaching the farthest vertex, which is never looser than the
+ *  sphere through the box corners
+ */
+static void _calculate_bounds(Mesh* M, const void* vertex_data, size_t vertex_count, VertexFormat vertex_format,
+                              const PositionQuantization* quantization)
+{
+    Vec3 min = vec3_zero, max = vec3_zero;
+    float radius_sq = 0.0f;
+    size_t ii;
+    for(ii=0;ii<vertex_count;++ii) {
+        Vec3 position = _get_vertex_position(vertex_data, ii, vertex_format, quantization);
+        min = ii ? vec3_min(min, position) : position;
+        max = ii ? vec3_max(max, position) : position;
+    }
+    M->bounds_center = vec3_mul_scalar(vec3_add(min, max), 0.5f);
+    M->bounds_extents = vec3_mul_scalar(vec3_sub(max, min), 0.5f);
+    for(ii=0;ii<vertex_count;++ii) {
+        Vec3 offset = vec3_sub(_get_vertex_position(vertex_data, ii, vertex_format, quantization), M->bounds_center);
+        float distance_sq = vec3_length_sq(offset);
+        if(distance_sq > radius_sq)
+            radius_sq = distance_sq;
+    }
+    M->bounds_radius = sqrtf(radius_sq);
+}
+static void _set_vertex_pointers(VertexFormat format, uint32_t base_vertex)
+{
+    size_t base = (size_t)base_vertex*get_vertex_size(format);
+    switch(format) {
+    case kVertexFormatFloat:
+        ASSERT_GL(glVertexAttribPointer(kPositionSlot,    3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(base + offsetof(Vertex, position))));
+        ASSERT_GL(glVertexAttribPointer(kNormalSlot,      3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(base + offsetof(Vertex, normal))));
+        ASSERT_GL(glVertexAttribPointer(kTangentSlot,     3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(base + offsetof(Vertex, tangent))));
+        ASSERT_GL(glVertexAttribPointer(kBitangentSlot,   3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(base + offsetof(Vertex, bitangent))));
+        ASSERT_GL(glVertexAttribPointer(kTexCoordSlot,    2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(base + offsetof(Vertex, texcoord))));
+        break;
+    case kVertexFormatQTangent:
+        ASSERT_GL(glVertexAttribPointer(kPositionSlot,    3, GL_FLOAT, GL_FALSE, sizeof(QTangentVertex), (void*)(base + offsetof(QTangentVertex, position))));
+        ASSERT_GL(glVertexAttribPointer(kQTangentSlot,    4, GL_SHORT, GL_TRUE,  sizeof(QTangentVertex), (void*)(base + offsetof(QTangentVertex, qtangent))));
+        ASSERT_GL(glVertexAttribPointer(kTexCoordSlot,    2, GL_FLOAT, GL_FALSE, sizeof(QTangentVertex), (void*)(base + offsetof(QTangentVertex, texcoord))));
+        break;
+    case kVertexFormatCompressed:
+        ASSERT_GL(glVertexAttribPointer(kPositionSlot,    3, GL_UNSIGNED_SHORT,        GL_TRUE,  sizeof(CompressedVertex), (void*)(base + offsetof(CompressedVertex, position))));
+        ASSERT_GL(glVertexAttribPointer(kNormalSlot,      4, GL_INT_2_10_10_10_REV,    GL_TRUE,  sizeof(CompressedVertex), (void*)(base + offsetof(CompressedVertex, normal))));
+        ASSERT_GL(glVertexAttribPointer(kTangentSlot,     4, GL_INT_2_10_10_10_REV,    GL_TRUE,  sizeof(CompressedVertex), (void*)(base + offsetof(CompressedVertex, tangent))));
+        ASSERT_GL(glVertexAttribPointer(kTexCoordSlot,    2, GL_HALF_FLOAT,            GL_FALSE, sizeof(CompressedVertex), (void*)(base + offsetof(CompressedVertex, texcoord))));
+        break;
+    default:
+        assert(0);
+    }
+}
+
+static void _enable_attributes(VertexFormat format)
+{
+    const AttributeSlot* slots = kMeshAttributeSlots[format];
+    while(*slots != kEmptySlot && *slots != kPositionScaleSlot) {
+        ASSERT_GL(glEnableVertexAttribArray(*slots));
+        ++slots;
+    }
+}
+/** Binds the vertex array of an arena window, creating it if needed */
+static void _bind_window(GeometryArena* A, int window)
+{
+    ArenaWindow* W = &A->windows[window];
+    if(W->vertex_array == 0) {
+        ASSERT_GL(glGenVertexArrays(1, &W->vertex_array));
+        ASSERT_GL(glBindVertexArray(W->vertex_array));
+        ASSERT_GL(glBindBuffer(GL_ARRAY_BUFFER, A->vertex_buffer));
+        ASSERT_GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, A->index_buffer));
+        _enable_attributes(A->vertex_format);
+        _set_vertex_pointers(A->vertex_format, W->base_vertex);
+        ASSERT_GL(glBindBuffer(GL_ARRAY_BUFFER, 0));
+        _bound_vertex_array = W->vertex_array;
+    } else if(W->vertex_array != _bound_vertex_array) {
+        ASSERT_GL(glBindVertexArray(W->vertex_array));
+        _bound_vertex_array = W->vertex_array;
+    }
+}
 
 /* External functions
  */
-Mesh* create_mesh(const Vertex* vertex_data, size_t vertex_data_size,
+void set_vertex_format(VertexFormat format)
+{
+    assert(format >= 0 && format < kNumVertexFormats);
+    _vertex_format = format;
+}
+VertexFormat get_vertex_format(void)
+{
+    return _vertex_format;
+}
+const AttributeSlot* get_mesh_attribute_slots(void)
+{
+    return kMeshAttributeSlots[_vertex_format];
+}
+void begin_mesh_draws(void)
+{
+    _bound_vertex_array = 0;
+}
+GeometryArena* create_geometry_arena(void)
+{
+    GeometryArena* arena = (GeometryArena*)calloc(1, sizeof(GeometryArena));
+    arena->vertex_format = _vertex_format;
+    return arena;
+}
+void reserve_geometry_arena(GeometryArena* A, size_t vertex_count, size_t index_count)
+{
+    size_t vertex_size = get_vertex_size(A->vertex_format);
+    int replaced = _reserve_buffer(&A->vertex_buffer, A->vertex_count*vertex_size, &A->vertex_buffer_size,
+                                   (A->vertex_count + vertex_count)*vertex_size);
+    replaced |= _reserve_buffer(&A->index_buffer, A->index_bytes, &A->index_buffer_size,
+                                A->index_bytes + index_count*sizeof(uint16_t));
+    if(replaced)
+        _release_vertex_arrays(A);
+}
+void destroy_geometry_arena(GeometryArena* A)
+{
+    _release_vertex_arrays(A);
+    ASSERT_GL(glDeleteBuffers(1,&A->vertex_buffer));
+    ASSERT_GL(glDeleteBuffers(1,&A->index_buffer));
+    free(A->windows);
+    free(A);
+}
+Mesh* create_mesh(GeometryArena* arena,
+                  const void* vertex_data, size_t vertex_data_size, VertexFormat vertex_format,
+                  const PositionQuantization* quantization,
                   const uint32_t* index_data, size_t index_data_size,
-                  int index_count)
+                  int index_count,
+                  const MeshLod* lods, int num_lods)
 {
     Mesh*   mesh = NULL;
-    GLuint  vertex_buffer = 0;
-    GLuint  index_buffer = 0;
+    void*   converted = NULL;
+    PositionQuantization mesh_quantization = { {1.0f, 1.0f, 1.0f}, {0.0f, 0.0f, 0.0f} };
+    MeshLod whole_mesh = { 0, 0, 0.0f };
+    size_t  vertex_count = vertex_data_size/get_vertex_size(vertex_format);
+    uint32_t first_vertex = (uint32_t)arena->vertex_count;
+    size_t  vertex_offset = 0;
+    size_t  index_offset = 0;
+    int ii;
+    uint32_t jj;
 
-    /* Create vertex buffer */
-    ASSERT_GL(glGenBuffers(1, &vertex_buffer));
-    ASSERT_GL(glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer));
-    ASSERT_GL(glBufferData(GL_ARRAY_BUFFER, vertex_data_size, vertex_data, GL_STATIC_DRAW));
-    ASSERT_GL(glBindBuffer(GL_ARRAY_BUFFER, 0));
+    assert(vertex_format != kVertexFormatCompressed || quantization);
+    assert(arena->vertex_format == _vertex_format);
+    if(vertex_format == kVertexFormatCompressed)
+        mesh_quantization = *quantization;
+    if(lods == NULL || num_lods == 0) {
+        whole_mesh.index_count = (uint32_t)index_count;
+        lods = &whole_mesh;
+        num_lods = 1;
+    }
+    assert(num_lods <= MAX_MESH_LODS);
 
-    /* Create index buffer */
-    ASSERT_GL(glGenBuffers(1, &index_buffer));
-    ASSERT_GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer));
-    ASSERT_GL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_data_size, index_data, GL_STATIC_DRAW));
-    ASSERT_GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+    mesh = (Mesh*)calloc(1, sizeof(Mesh));
+    _calculate_bounds(mesh, vertex_data, vertex_count, vertex_format, quantization);
+
+    /* Convert the vertices to the runtime format */
+    if(vertex_format != _vertex_format) {
+        converted = _convert_vertices(vertex_data, vertex_format, quantization,
+                                      vertex_count, _vertex_format, &mesh_quantization);
+        vertex_data = converted;
+        vertex_data_size = vertex_count*get_vertex_size(_vertex_format);
+    }
+
+    /* Append the vertices */
+    vertex_offset = arena->vertex_count*get_vertex_size(_vertex_format);
+    if(_reserve_buffer(&arena->vertex_buffer, vertex_offset, &arena->vertex_buffer_size, vertex_offset + vertex_data_size))
+        _release_vertex_arrays(arena);
+    ASSERT_GL(glBindBuffer(GL_COPY_WRITE_BUFFER, arena->vertex_buffer));
+    ASSERT_GL(glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)vertex_offset, (GLsizeiptr)vertex_data_size, vertex_data));
+    ASSERT_GL(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+    arena->vertex_count += vertex_count;
+    free(converted);
+
+    /* Append the indices, 16 bit when every range fits. Ranges are rebased
+     * onto the arena's current window when they fit in it */
+    mesh->num_lods = num_lods;
+    for(ii=0;ii<num_lods;++ii)
+        mesh->lods[ii].error = lods[ii].error;
+    if(_split_lod_ranges(mesh, index_data, lods, num_lods)) {
+        uint16_t* short_indices = (uint16_t*)malloc((size_t)index_count*sizeof(uint16_t));
+        for(ii=0;ii<mesh->num_ranges;++ii) {
+            MeshRange* range = &mesh->ranges[ii];
+            uint32_t first = first_vertex + range->base_vertex;
+            uint32_t last = first;
+            for(jj=range->first_index; jj<range->first_index+range->index_count; ++jj)
+                last = first_vertex + index_data[jj] > last ? first_vertex + index_data[jj] : last;
+            if(first < arena->window_base || last - arena->window_base > kMaxShortIndexSpan)
+                arena->window_base = first;
+            range->base_vertex = arena->window_base;
+            for(jj=range->first_index; jj<range->first_index+range->index_count; ++jj)
+                short_indices[jj] = (uint16_t)(first_vertex + index_data[jj] - range->base_vertex);
+        }
+        index_offset = _append_indices(arena, short_indices, (size_t)index_count*sizeof(uint16_t));
+        free(short_indices);
+        mesh->index_type = GL_UNSIGNED_SHORT;
+        mesh->index_bytes_saved = index_data_size - (size_t)index_count*sizeof(uint16_t);
+        index_offset /= sizeof(uint16_t);
+    } else {
+        /* Already 32 bit, so upload them as they are and draw them with a
+         * window of their own starting at the mesh's first vertex */
+        index_offset = _append_indices(arena, index_data, index_data_size)/sizeof(uint32_t);
+        mesh->ranges = (MeshRange*)calloc((size_t)num_lods, sizeof(MeshRange));
+        for(ii=0;ii<num_lods;++ii) {
+            mesh->ranges[ii].first_index = lods[ii].first_index;
+            mesh->ranges[ii].index_count = lods[ii].index_count;
+            mesh->ranges[ii].base_vertex = first_vertex;
+            mesh->lods[ii].first_range = ii;
+            mesh->lods[ii].num_ranges = 1;
+        }
+        mesh->num_ranges = num_lods;
+        mesh->index_type = GL_UNSIGNED_INT;
+    }
+    for(ii=0;ii<mesh->num_ranges;++ii) {
+        mesh->ranges[ii].first_index += (uint32_t)index_offset;
+        mesh->ranges[ii].window = _find_window(arena, mesh->ranges[ii].base_vertex);
+    }
 
     /* Create mesh */
-    mesh = (Mesh*)calloc(1, sizeof(Mesh));
-    mesh->vertex_buffer = vertex_buffer;
-    mesh->index_buffer = index_buffer;
+    mesh->arena = arena;
     mesh->index_count = index_count;
+    mesh->vertex_format = _vertex_format;
+    mesh->quantization = mesh_quantization;
 
     return mesh;
 }
-void draw_mesh(const Mesh* M)
+void draw_mesh(const Mesh* M, int lod)
+{
+    size_t index_size = M->index_type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+    const MeshLodRanges* lod_ranges;
+    int ii;
+    lod = lod < 0 ? 0 : (lod >= M->num_lods ? M->num_lods-1 : lod);
+    lod_ranges = &M->lods[lod];
+    if(M->vertex_format == kVertexFormatCompressed) {
+        ASSERT_GL(glVertexAttrib3fv(kPositionScaleSlot, &M->quantization.scale.x));
+        ASSERT_GL(glVertexAttrib3fv(kPositionBiasSlot, &M->quantization.bias.x));
+    }
+    for(ii=lod_ranges->first_range; ii<lod_ranges->first_range+lod_ranges->num_ranges; ++ii) {
+        const MeshRange* range = &M->ranges[ii];
+        _bind_window(M->arena, range->window);
+        ASSERT_GL(glDrawElements(GL_TRIANGLES, (GLsizei)range->index_count, M->index_type,
+                                 (void*)(range->first_index*index_size)));
+    }
+}
+int get_mesh_lod_count(const Mesh* M)
+{
+    return M->num_lods;
+}
+void get_mesh_bounds(const Mesh* M, Vec3* center, float* radius)
+{
+    *center = M->bounds_center;
+    *radius = M->bounds_radius;
+}
+void get_mesh_box(const Mesh* M, Vec3* center, Vec3* extents)
+{
+    *center = M->bounds_center;
+    *extents = M->bounds_extents;
+}
+int select_mesh_lod(const Mesh* M, float projected_radius)
+{
+    int ii;
+    for(ii=M->num_lods-1; ii>0; --ii) {
+        if(M->lods[ii].error*projected_radius <= kLodPixelError)
+            return ii;
+    }
+    return 0;
+}
+size_t get_mesh_index_bytes_saved(const Mesh* M)
 {
-    float* ptr = 0;
-    ASSERT_GL(glBindBuffer(GL_ARRAY_BUFFER, M->vertex_buffer));
-    ASSERT_GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, M->index_buffer));
-    ASSERT_GL(glVertexAttribPointer(kPositionSlot,    3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(ptr+=0)));
-    ASSERT_GL(glVertexAttribPointer(kNormalSlot,      3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(ptr+=3)));
-    ASSERT_GL(glVertexAttribPointer(kTangentSlot,     3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(ptr+=3)));
-    ASSERT_GL(glVertexAttribPointer(kBitangentSlot,   3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(ptr+=3)));
-    ASSERT_GL(glVertexAttribPointer(kTexCoordSlot,    2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(ptr+=3)));
-    ASSERT_GL(glDrawElements(GL_TRIANGLES, M->index_count, GL_UNSIGNED_INT, NULL));
+    return M->index_bytes_saved;
 }
 void destroy_mesh(Mesh* M)
 {
-    ASSERT_GL(glDeleteBuffers(1,&M->vertex_buffer));
-    ASSERT_GL(glDeleteBuffers(1,&M->index_buffer));
+    free(M->ranges);
     free(M);
 }
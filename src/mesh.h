@@ -22,11 +22,83 @@
 #include "vertex.h"
 #include "graphics_types.h"
 
+#define MAX_MESH_LODS 4
 
-Mesh* create_mesh(const Vertex* vertex_data, size_t vertex_data_size,
+/** One level of detail. Every level indexes the same vertices, and the
+ *  levels follow each other in the index data, finest first
+ */
+typedef struct MeshLod
+{
+    uint32_t    first_index;
+    uint32_t    index_count;
+    float       error;  /* Geometric error, relative to the bounding radius */
+} MeshLod;
+
+typedef struct GeometryArena GeometryArena;
+
+/** @brief Chooses the vertex layout meshes are uploaded in. Meshes created
+ *      afterwards convert their vertex data to it, so set it before loading
+ *      a scene, and create the renderers after setting it
+ */
+void set_vertex_format(VertexFormat format);
+VertexFormat get_vertex_format(void);
+/** @return The kEmptySlot terminated attribute slots of the current format,
+ *      for binding with create_program
+ */
+const AttributeSlot* get_mesh_attribute_slots(void);
+
+/** @brief Creates the vertex and index buffers a set of meshes, such as a
+ *      scene's, is suballocated from. They hold vertices in the current
+ *      format, and grow as meshes are added
+ */
+GeometryArena* create_geometry_arena(void);
+/** @brief Makes room for `vertex_count` more vertices and `index_count` more
+ *      16 bit indices, to avoid growing the buffers mesh by mesh
+ */
+void reserve_geometry_arena(GeometryArena* A, size_t vertex_count, size_t index_count);
+/** @brief Destroys the buffers. Destroy the arena's meshes first
+ */
+void destroy_geometry_arena(GeometryArena* A);
+
+/** @brief Starts a run of draw_mesh calls. draw_mesh binds a vertex array
+ *      object per 16 bit window of the arena, and skips the bind when the
+ *      previous mesh used the same one, so call this whenever another vertex
+ *      array was bound in between
+ */
+void begin_mesh_draws(void);
+
+/** @param arena  Arena the vertices and indices are appended to
+ *  @param vertex_format  Layout of `vertex_data`. It is uploaded as is when it
+ *      matches get_vertex_format(), otherwise it's converted first
+ *  @param quantization  Dequantization constants of kVertexFormatCompressed
+ *      data, NULL for the other formats
+ *  @param lods  The levels of detail in `index_data`, or NULL to draw all
+ *      `index_count` indices as a single level
+ */
+Mesh* create_mesh(GeometryArena* arena,
+                  const void* vertex_data, size_t vertex_data_size, VertexFormat vertex_format,
+                  const PositionQuantization* quantization,
                   const uint32_t* index_data, size_t index_data_size,
-                  int index_count);
-void draw_mesh(const Mesh* M);
+                  int index_count,
+                  const MeshLod* lods, int num_lods);
+/** @param lod  Level of detail, clamped to the ones the mesh has
+ */
+void draw_mesh(const Mesh* M, int lod);
+int get_mesh_lod_count(const Mesh* M);
+/** @brief Bounding sphere of the mesh in model space
+ */
+void get_mesh_bounds(const Mesh* M, Vec3* center, float* radius);
+/** @brief Axis aligned bounding box of the mesh in model space, as its
+ *      center (shared with the sphere) and half size
+ */
+void get_mesh_box(const Mesh* M, Vec3* center, Vec3* extents);
+/** @return The coarsest level whose error stays under a pixel when the
+ *      bounding sphere covers `projected_radius` pixels on screen
+ */
+int select_mesh_lod(const Mesh* M, float projected_radius);
+/** @return Bytes of index buffer saved by storing 16 bit indices
+ */
+size_t get_mesh_index_bytes_saved(const Mesh* M);
 void destroy_mesh(Mesh* M);
 
 #endif /* include guard */
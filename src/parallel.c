@@ -0,0 +1,107 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "parallel.h"
+#include <pthread.h>
+#include <unistd.h>
+
+/* Defines
+ */
+#define MAX_THREADS 64
+
+/* Types
+ */
+typedef struct ParallelJob
+{
+    ParallelTask*   task;
+    void*           data;
+    int             count;
+    volatile int    next;
+} ParallelJob;
+typedef struct ParallelWorker
+{
+    ParallelJob*    job;
+    int             thread;
+} ParallelWorker;
+
+/* Constants
+ */
+
+/* Variables
+ */
+
+/* Internal functions
+ */
+static void* _parallel_worker(void* arg)
+{
+    ParallelWorker* worker = (ParallelWorker*)arg;
+    ParallelJob* job = worker->job;
+    while(1) {
+        int index = __sync_fetch_and_add(&job->next, 1);
+        if(index >= job->count)
+            break;
+        job->task(job->data, index, worker->thread);
+    }
+    return NULL;
+}
+
+/* External functions
+ */
+void parallel_for(int num_threads, int count, ParallelTask* task, void* data)
+{
+    pthread_t       threads[MAX_THREADS];
+    ParallelWorker  workers[MAX_THREADS];
+    ParallelJob     job;
+    int             num_started = 0;
+    int             ii;
+
+    if(num_threads <= 0)
+        num_threads = num_cpu_threads();
+    if(num_threads > count)
+        num_threads = count;
+    if(num_threads < 1)
+        num_threads = 1;
+    if(num_threads > MAX_THREADS)
+        num_threads = MAX_THREADS;
+
+    job.task = task;
+    job.data = data;
+    job.count = count;
+    job.next = 0;
+
+    /* The calling thread is worker 0 */
+    for(ii=0; ii<num_threads; ++ii) {
+        workers[ii].job = &job;
+        workers[ii].thread = ii;
+    }
+    for(ii=1; ii<num_threads; ++ii) {
+        if(pthread_create(&threads[num_started], NULL, _parallel_worker, &workers[num_started+1]) == 0)
+            ++num_started;
+    }
+    _parallel_worker(&workers[0]);
+    for(ii=0; ii<num_started; ++ii) {
+        pthread_join(threads[ii], NULL);
+    }
+}
+int num_cpu_threads(void)
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    if(count < 1)
+        return 1;
+    if(count > MAX_THREADS)
+        return MAX_THREADS;
+    return (int)count;
+}
@@ -0,0 +1,41 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __parallel_h__
+#define __parallel_h__
+
+/** @brief A task run by `parallel_for`
+ *  @param data [in] The `data` pointer passed to `parallel_for`
+ *  @param index [in] The index of this task, in [0, count)
+ *  @param thread [in] The thread running this task, in [0, num_threads).
+ *         Tasks on the same thread never overlap, so it can index
+ *         per-thread scratch space
+ */
+typedef void (ParallelTask)(void* data, int index, int thread);
+
+/** @brief Runs `task(data, ii)` for every `ii` in [0, count), spread over up
+ *         to `num_threads` threads, and returns when all tasks have finished.
+ *         Tasks are handed out in index order as threads become free.
+ *  @param num_threads [in] Threads to use, including the calling thread. 0
+ *         uses one per CPU, 1 runs everything on the calling thread
+ */
+void parallel_for(int num_threads, int count, ParallelTask* task, void* data);
+
+/** @return The number of CPUs available to run threads on
+ */
+int num_cpu_threads(void);
+
+#endif /* include guard */
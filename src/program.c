@@ -35,6 +35,9 @@ static const char* kAttributeSlotNames[] =
     "a_Tangent",    /* kTangentSlot */
     "a_Bitangent",  /* kBitangentSlot */
     "a_TexCoord",   /* kTexCoordSlot */
+    "a_QTangent",   /* kQTangentSlot */
+    "a_PositionScale",  /* kPositionScaleSlot */
+    "a_PositionBias",   /* kPositionBiasSlot */
 };
 
 /* Variables
@@ -17,6 +17,8 @@
 #ifndef __scene_h__
 #define __scene_h__
 
+#include <stddef.h>
+#include <stdint.h>
 #include "texture.h"
 #include "vec_math.h"
 #include "graphics_types.h"
@@ -34,19 +36,47 @@ typedef struct Material
 } Material;
 typedef struct Model
 {
-    char        name[64];
+    /* What rendering reads comes first, to share a cache line */
     Transform   transform;
     Mesh*       mesh;
     Material*   material;
+    char        name[64];
 } Model;
 
+/** Loads a .obj, .mesh or .scene file. Lights listed in a .scene are
+ *  submitted by render_scene along with the models
+ *  @return NULL if the file can't be loaded
+ */
 Scene* create_scene(const char* filename);
 void destroy_scene(Scene* S);
 void render_scene(Scene* S, Graphics* G);
 
 Model* get_model(Scene* S, int model);
 
-SceneData* _load_scene_data(const char* filename);
-void _free_scene_data(SceneData* S);
+/** Sets the number of threads OBJ files are parsed with. 0 (the default)
+ *  uses one per CPU
+ */
+void set_scene_load_threads(int num_threads);
+/** Streams OBJ files through a fixed-size window instead of loading them
+ *  whole, turning each material group into a mesh as soon as it ends. The
+ *  window is sized from `max_bytes`, and a load that needs more than that,
+ *  or has a longer line, fails. 0 (the default) loads files whole, in
+ *  parallel
+ */
+void set_scene_load_memory_limit(size_t max_bytes);
+/** Timings, in seconds, and memory use of the last OBJ load
+ */
+typedef struct SceneLoadStats
+{
+    double      total_time;
+    double      parse_time;     /* Reading and tokenizing the OBJ and MTLs */
+    double      weld_time;      /* Summed over all threads */
+    double      tangent_time;   /* Summed over all threads */
+    size_t      file_size;
+    size_t      peak_memory;    /* File data, parse results and finished meshes */
+    uint32_t    num_vertices;
+    uint32_t    num_triangles;
+} SceneLoadStats;
+void get_scene_load_stats(SceneLoadStats* stats);
 
 #endif /* include guard */
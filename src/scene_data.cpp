@@ -0,0 +1,1784 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+
+extern "C" {
+#include "scene.h"
+#include "scene_data.h"
+#include "vertex.h"
+#include "utility.h"
+#include "system.h"
+#include "assert.h"
+#include "parallel.h"
+#include "timer.h"
+#include "simd.h"
+}
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <string>
+#include <sstream>
+
+/* Defines
+ */
+
+/* Types
+ */
+struct SimpleVertex
+{
+    Vec3    position;
+    Vec3    normal;
+    Vec2    texcoord;
+};
+static void _print_mesh_data(const MeshData* M)
+{
+    printf("\t%s\n", M->name);
+    printf("\tIndex count:\t%d\n", M->index_count);
+    printf("\tVertex count:\t%d\n", M->vertex_count);
+    printf("\tVertices:\t\t%p\n", (void*)M->vertices);
+    printf("\tIndices:\t\t%p\n", (void*)M->indices);
+    printf("\n");
+}
+static void _print_material_data(const MaterialData* M)
+{
+    printf("\t%s\n", M->name);
+    printf("\tAlbedo:\t\t%s\n", M->albedo_tex);
+    printf("\tNormal:\t\t%s\n", M->normal_tex);
+    printf("\tSpecular :\t%f\n", M->specular_coefficient);
+    printf("\tSpecular power:\t%f\n", M->specular_power);
+    printf("\tSpecular color:\t%f\n", M->specular_color.x);
+    printf("\n");
+}
+static void _print_model_data(const ModelData* M)
+{
+    printf("\tMesh:\t%s\n", M->mesh_name);
+    printf("\tMaterial:\t%s\n", M->material_name);
+    printf("\n");
+}
+/** Sources are hashed a block at a time, chaining the hash through the seed,
+ *  so a file can be hashed while it is streamed in
+ */
+static const size_t kSourceBlockSize = 64*1024;
+static uint64_t _hash_source_block(const void* block, size_t size, uint64_t hash)
+{
+    return size ? hash_data(block, size, hash) : hash;
+}
+static uint64_t _hash_source_data(const void* data, size_t size)
+{
+    uint64_t hash = 0;
+    for(size_t offset=0; offset<size; offset+=kSourceBlockSize) {
+        size_t block = size - offset < kSourceBlockSize ? size - offset : kSourceBlockSize;
+        hash = _hash_source_block((const char*)data + offset, block, hash);
+    }
+    return hash;
+}
+static void _add_scene_source(SceneData* scene, const char* filename, uint64_t hash)
+{
+    SceneSource* source;
+    scene->sources = (SceneSource*)realloc(scene->sources, sizeof(SceneSource)*(scene->num_sources+1));
+    source = scene->sources + scene->num_sources++;
+    memset(source, 0, sizeof(*source));
+    strncpy(source->filename, filename, sizeof(source->filename)-1);
+    source->hash = hash;
+}
+
+/* Constants
+ */
+
+/* Variables
+ */
+
+/* Internal functions
+ */
+/* OBJ/MTL tokenizer
+ *
+ * All of these work in place on the buffer returned by `load_file_data`. That
+ * buffer is not null-terminated, so every function is bounded by `end`.
+ */
+static const double kPowersOf10[] =
+{
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+    1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+    1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+static inline int _is_space(char c)
+{
+    return c == ' ' || c == '\t';
+}
+static inline int _is_end_of_line(char c)
+{
+    return c == '\n' || c == '\r' || c == '\0';
+}
+static inline int _is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+static inline const char* _skip_space(const char* p, const char* end)
+{
+    while(p < end && _is_space(*p))
+        ++p;
+    return p;
+}
+static inline const char* _skip_token(const char* p, const char* end)
+{
+    while(p < end && !_is_space(*p) && !_is_end_of_line(*p))
+        ++p;
+    return p;
+}
+/** @return The start of the line following `p`. Handles "\n", "\r\n" and "\r"
+ */
+static inline const char* _skip_line(const char* p, const char* end)
+{
+    while(p < end && *p != '\n' && *p != '\r')
+        ++p;
+    if(p < end && *p == '\r')
+        ++p;
+    if(p < end && *p == '\n')
+        ++p;
+    return p;
+}
+static inline int _token_is(const char* token, const char* token_end, const char* string)
+{
+    size_t length = strlen(string);
+    return (size_t)(token_end - token) == length && memcmp(token, string, length) == 0;
+}
+/** Copies the next whitespace-delimited token into `dest`, truncating it if
+ *  needed. `dest` is always null-terminated.
+ */
+static const char* _copy_token(char* dest, size_t dest_size, const char* p, const char* end)
+{
+    const char* token = _skip_space(p, end);
+    const char* token_end = _skip_token(token, end);
+    size_t length = (size_t)(token_end - token);
+    if(length >= dest_size)
+        length = dest_size - 1;
+    memcpy(dest, token, length);
+    dest[length] = '\0';
+    return token_end;
+}
+/** Parses a float exactly as `strtof` would.
+ *
+ *  The common "-12.345678" case is handled with one double multiply or divide
+ *  of exactly representable operands, which is correctly rounded. Everything
+ *  else (long mantissas, large exponents, inf/nan, and the rare double that
+ *  lands on a float rounding midpoint) goes through `strtof`.
+ *  @return A pointer past the number, NULL if there is no number
+ */
+static const char* _parse_float(const char* p, const char* end, float* value)
+{
+    const char* start = _skip_space(p, end);
+    uint64_t    mantissa = 0;
+    int         num_digits = 0;
+    int         significant_digits = 0;
+    int         exponent = 0;
+    int         negative = 0;
+    double      result;
+
+    p = start;
+    if(p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        ++p;
+    }
+    while(p < end && _is_digit(*p)) {
+        if(mantissa || *p != '0')
+            ++significant_digits;
+        mantissa = mantissa*10 + (uint64_t)(*p - '0');
+        ++num_digits;
+        ++p;
+    }
+    if(p < end && *p == '.') {
+        ++p;
+        while(p < end && _is_digit(*p)) {
+            if(mantissa || *p != '0')
+                ++significant_digits;
+            mantissa = mantissa*10 + (uint64_t)(*p - '0');
+            --exponent;
+            ++num_digits;
+            ++p;
+        }
+    }
+    if(num_digits == 0)
+        goto slow_path;
+    if(p < end && (*p == 'e' || *p == 'E')) {
+        int exponent_negative = 0;
+        int explicit_exponent = 0;
+        ++p;
+        if(p < end && (*p == '-' || *p == '+')) {
+            exponent_negative = (*p == '-');
+            ++p;
+        }
+        if(p == end || !_is_digit(*p))
+            goto slow_path;
+        while(p < end && _is_digit(*p)) {
+            if(explicit_exponent < 10000)
+                explicit_exponent = explicit_exponent*10 + (*p - '0');
+            ++p;
+        }
+        exponent += exponent_negative ? -explicit_exponent : explicit_exponent;
+    }
+    if(p < end && !_is_space(*p) && !_is_end_of_line(*p))
+        goto slow_path;
+
+    if(mantissa == 0) {
+        *value = negative ? -0.0f : 0.0f;
+        return p;
+    }
+    /* Up to 15 digits always fit in the 53 bit double mantissa */
+    if(significant_digits > 15 || exponent < -22 || exponent > 22)
+        goto slow_path;
+    if(exponent < 0)
+        result = (double)mantissa / kPowersOf10[-exponent];
+    else
+        result = (double)mantissa * kPowersOf10[exponent];
+    {
+        /* A correctly rounded double only rounds differently to float than
+         * the exact value would if it sits exactly on a float midpoint
+         */
+        uint64_t bits;
+        memcpy(&bits, &result, sizeof(bits));
+        if((bits & 0x1FFFFFFF) == 0x10000000)
+            goto slow_path;
+    }
+    *value = negative ? -(float)result : (float)result;
+    return p;
+
+slow_path:
+    {
+        char buffer[64];
+        char* number_end = NULL;
+        _copy_token(buffer, sizeof(buffer), start, end);
+        *value = strtof(buffer, &number_end);
+        if(number_end == buffer)
+            return NULL;
+        return start + (number_end - buffer);
+    }
+}
+/** @return A pointer past the number, NULL if there is no number
+ */
+static inline const char* _parse_int(const char* p, const char* end, int* value)
+{
+    int negative = 0;
+    int result = 0;
+    const char* digits;
+
+    if(p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        ++p;
+    }
+    digits = p;
+    while(p < end && _is_digit(*p)) {
+        result = result*10 + (*p - '0');
+        ++p;
+    }
+    if(p == digits)
+        return NULL;
+    *value = negative ? -result : result;
+    return p;
+}
+
+static void _load_mtl_file(const char* path, const char* filename, SceneData* scene)
+{
+    std::string path_string(path);
+    std::string mtl_filename = path_string + filename;
+    std::vector<MaterialData> materials;
+    char* file_data = NULL;
+    size_t file_size = 0;
+
+    /* A library referenced more than once is only loaded the first time */
+    for(uint32_t ii=0; ii<scene->num_sources; ++ii) {
+        if(strcmp(scene->sources[ii].filename, mtl_filename.c_str()) == 0)
+            return;
+    }
+
+    /* Without the library the models have no materials */
+    if(load_file_data(mtl_filename.c_str(), (void**)&file_data, &file_size) != 0)
+        return;
+    _add_scene_source(scene, mtl_filename.c_str(), _hash_source_data(file_data, file_size));
+
+    const char* end = file_data + file_size;
+    const char* line = file_data;
+    while(line < end) {
+        const char* next_line = _skip_line(line, end);
+        const char* header = _skip_space(line, next_line);
+        const char* header_end = _skip_token(header, next_line);
+        const char* p = header_end;
+
+        if(_token_is(header, header_end, "newmtl")) {
+            MaterialData material;
+            memset(&material, 0, sizeof(material));
+            _copy_token(material.name, sizeof(material.name), p, next_line);
+            material.specular_power = 16.0f;
+            materials.push_back(material);
+        } else if(materials.empty()) {
+            /* Nothing to apply properties to yet */
+        } else if(_token_is(header, header_end, "map_Kd")) {
+            MaterialData& material = materials.back();
+            _copy_token(material.albedo_tex, sizeof(material.albedo_tex), p, next_line);
+        } else if(_token_is(header, header_end, "map_bump") && materials.back().normal_tex[0] == '\0') {
+            MaterialData& material = materials.back();
+            _copy_token(material.normal_tex, sizeof(material.normal_tex), p, next_line);
+        } else if(_token_is(header, header_end, "Ks")) {
+            Vec3 spec_color = vec3_zero;
+            p = _parse_float(p, next_line, &spec_color.x);
+            if(p) p = _parse_float(p, next_line, &spec_color.y);
+            if(p) p = _parse_float(p, next_line, &spec_color.z);
+            assert(p);
+            materials.back().specular_color = spec_color;
+        } else if(_token_is(header, header_end, "Ns")) {
+            p = _parse_float(p, next_line, &materials.back().specular_coefficient);
+            assert(p);
+        }
+        line = next_line;
+    }
+    free_file_data(file_data);
+
+    //
+    // Append materials. When libraries share a material name the first
+    // definition wins, which is the one `usemtl` binds to
+    //
+    if(materials.empty())
+        return;
+    scene->materials = (MaterialData*)realloc(scene->materials, (scene->num_materials+materials.size())*sizeof(MaterialData));
+    NameIndex index;
+    _build_name_index(&index, scene->materials, sizeof(MaterialData), scene->num_materials);
+    for(size_t ii=0; ii<materials.size(); ++ii) {
+        scene->materials[scene->num_materials] = materials[ii];
+        if(_add_name(&index, scene->materials, sizeof(MaterialData), scene->num_materials) == scene->num_materials)
+            ++scene->num_materials;
+    }
+    _free_name_index(&index);
+}
+/* Tangent frames
+ *
+ * Generated four triangles, then four vertices, at a time. Vertices are
+ * loaded as 16 byte rows and transposed into x, y, z vectors in registers:
+ *  1. Each triangle's unnormalized tangent and bitangent is added to its
+ *     corners. This runs in index order, so the sums are the same however
+ *     the meshes are threaded
+ *  2. Per vertex, the summed tangent is orthogonalized against the normal
+ *     (Gram-Schmidt) and the bitangent rebuilt as cross(n, t), flipped when
+ *     the summed bitangent points the other way (mirrored UVs)
+ * Triangles with degenerate texture coordinates contribute nothing. A vertex
+ * left without a tangent gets an arbitrary one perpendicular to its normal.
+ */
+static const SimpleVertex kNoVertex = { {0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 0.0f} };
+static const float kNoTangentSum[8] = { 0.0f };
+
+/** Loads the 16 bytes at `offset` in four vertices and transposes them */
+static inline void _load_transposed(const void* const* rows, size_t offset, Simd4* x, Simd4* y, Simd4* z, Simd4* w)
+{
+    Simd4 r0 = simd4_load((const float*)((const char*)rows[0] + offset));
+    Simd4 r1 = simd4_load((const float*)((const char*)rows[1] + offset));
+    Simd4 r2 = simd4_load((const float*)((const char*)rows[2] + offset));
+    Simd4 r3 = simd4_load((const float*)((const char*)rows[3] + offset));
+    simd4_transpose(&r0, &r1, &r2, &r3);
+    *x = r0, *y = r1, *z = r2, *w = r3;
+}
+static inline void _store_transposed(void* const* rows, size_t offset, Simd4 x, Simd4 y, Simd4 z, Simd4 w)
+{
+    simd4_transpose(&x, &y, &z, &w);
+    simd4_store((float*)((char*)rows[0] + offset), x);
+    simd4_store((float*)((char*)rows[1] + offset), y);
+    simd4_store((float*)((char*)rows[2] + offset), z);
+    simd4_store((float*)((char*)rows[3] + offset), w);
+}
+static Vertex* _calculate_tangents(const SimpleVertex* vertices, uint32_t num_vertices,
+                                   const uint32_t* indices, uint32_t num_indices,
+                                   std::vector<float>* scratch)
+{
+    uint32_t num_triangles = num_indices/3;
+    const Simd4 zero = simd4_splat(0.0f);
+    const Simd4 one = simd4_splat(1.0f);
+
+    /* Per vertex tangent xyz and bitangent xyz sums, eight floats apart so a
+     * vertex's sums share a cache line */
+    scratch->resize((size_t)num_vertices*8 + 8);
+    float* sums = &(*scratch)[0];
+    memset(sums, 0, num_vertices*8*sizeof(float));
+
+    //
+    // 1. Triangle tangents, added to their corners
+    //
+    const Simd4 min_area = simd4_splat(1e-20f);
+    for(uint32_t tt=0; tt<num_triangles; tt+=4) {
+        uint32_t lanes = (num_triangles - tt < 4) ? num_triangles - tt : 4;
+        const uint32_t* corners = indices + tt*3;
+
+        /* Corner positions and texture coordinates; missing lanes are all 0 */
+        Simd4 px[3], py[3], pz[3], u[3], v[3], unused;
+        for(int cc=0; cc<3; ++cc) {
+            const void* rows[4];
+            for(uint32_t ll=0; ll<4; ++ll)
+                rows[ll] = (ll < lanes) ? vertices + corners[ll*3+cc] : &kNoVertex;
+            _load_transposed(rows, offsetof(SimpleVertex, position), &px[cc], &py[cc], &pz[cc], &unused);
+            _load_transposed(rows, offsetof(SimpleVertex, normal.y), &unused, &unused, &u[cc], &v[cc]);
+        }
+        Simd4 e1x = simd4_sub(px[1], px[0]), e1y = simd4_sub(py[1], py[0]), e1z = simd4_sub(pz[1], pz[0]);
+        Simd4 e2x = simd4_sub(px[2], px[0]), e2y = simd4_sub(py[2], py[0]), e2z = simd4_sub(pz[2], pz[0]);
+        Simd4 du1 = simd4_sub(u[1], u[0]), dv1 = simd4_sub(v[1], v[0]);
+        Simd4 du2 = simd4_sub(u[2], u[0]), dv2 = simd4_sub(v[2], v[0]);
+
+        Simd4 det = simd4_sub(simd4_mul(du1, dv2), simd4_mul(dv1, du2));
+        Simd4Mask valid = simd4_greater(simd4_abs(det), min_area);
+        Simd4 r = simd4_select(valid, simd4_div(one, simd4_select(valid, det, one)), zero);
+
+        /* t = (e1*dv2 - e2*dv1)*r, b = (e2*du1 - e1*du2)*r, as one row per
+         * triangle: t.xyz, b.x and b.yz */
+        Simd4 t[8];
+        t[0] = simd4_mul(simd4_sub(simd4_mul(e1x, dv2), simd4_mul(e2x, dv1)), r);
+        t[1] = simd4_mul(simd4_sub(simd4_mul(e1y, dv2), simd4_mul(e2y, dv1)), r);
+        t[2] = simd4_mul(simd4_sub(simd4_mul(e1z, dv2), simd4_mul(e2z, dv1)), r);
+        t[3] = simd4_mul(simd4_sub(simd4_mul(e2x, du1), simd4_mul(e1x, du2)), r);
+        t[4] = simd4_mul(simd4_sub(simd4_mul(e2y, du1), simd4_mul(e1y, du2)), r);
+        t[5] = simd4_mul(simd4_sub(simd4_mul(e2z, du1), simd4_mul(e1z, du2)), r);
+        t[6] = zero;
+        t[7] = zero;
+        simd4_transpose(&t[0], &t[1], &t[2], &t[3]);
+        simd4_transpose(&t[4], &t[5], &t[6], &t[7]);
+
+        for(uint32_t ll=0; ll<lanes; ++ll) {
+            for(int cc=0; cc<3; ++cc) {
+                float* sum = sums + corners[ll*3+cc]*8;
+                simd4_store(sum, simd4_add(simd4_load(sum), t[ll]));
+                simd4_store(sum+4, simd4_add(simd4_load(sum+4), t[4+ll]));
+            }
+        }
+    }
+
+    //
+    // 2. Orthonormalize and write out the vertices
+    //
+    Vertex* new_vertices = (Vertex*)malloc(sizeof(Vertex)*num_vertices);
+    Vertex spare[4];
+    const Simd4 min_length = simd4_splat(1e-12f);
+    const Simd4 axis_limit = simd4_splat(0.9f);
+    for(uint32_t vv=0; vv<num_vertices; vv+=4) {
+        uint32_t lanes = (num_vertices - vv < 4) ? num_vertices - vv : 4;
+        const void* in[4];
+        const void* in_sums[4];
+        void* out[4];
+        for(uint32_t ll=0; ll<4; ++ll) {
+            in[ll] = (ll < lanes) ? vertices + vv + ll : &kNoVertex;
+            in_sums[ll] = (ll < lanes) ? sums + (vv+ll)*8 : kNoTangentSum;
+            out[ll] = (ll < lanes) ? new_vertices + vv + ll : spare + ll;
+        }
+
+        Simd4 nx, ny, nz, u, v, tx, ty, tz, bx, by, bz, unused;
+        _load_transposed(in, offsetof(SimpleVertex, normal), &nx, &ny, &nz, &unused);
+        _load_transposed(in, offsetof(SimpleVertex, normal.y), &unused, &unused, &u, &v);
+        _load_transposed(in_sums, 0, &tx, &ty, &tz, &bx);
+        _load_transposed(in_sums, 4*sizeof(float), &by, &bz, &unused, &unused);
+        Simd4 out_nx = nx, out_ny = ny, out_nz = nz;
+
+        Simd4 n_length = simd4_sqrt(simd4_dot3(nx, ny, nz, nx, ny, nz));
+        n_length = simd4_select(simd4_greater(n_length, min_length), n_length, one);
+        nx = simd4_div(nx, n_length);
+        ny = simd4_div(ny, n_length);
+        nz = simd4_div(nz, n_length);
+
+        /* Gram-Schmidt: t -= n*dot(n, t) */
+        Simd4 d = simd4_dot3(nx, ny, nz, tx, ty, tz);
+        tx = simd4_sub(tx, simd4_mul(nx, d));
+        ty = simd4_sub(ty, simd4_mul(ny, d));
+        tz = simd4_sub(tz, simd4_mul(nz, d));
+
+        /* Without a tangent, use the x (or, for normals along x, y) axis instead */
+        Simd4Mask missing = simd4_less(simd4_dot3(tx, ty, tz, tx, ty, tz), min_length);
+        Simd4Mask use_x = simd4_less(simd4_abs(nx), axis_limit);
+        d = simd4_select(use_x, nx, ny);
+        tx = simd4_select(missing, simd4_sub(simd4_select(use_x, one, zero), simd4_mul(nx, d)), tx);
+        ty = simd4_select(missing, simd4_sub(simd4_select(use_x, zero, one), simd4_mul(ny, d)), ty);
+        tz = simd4_select(missing, simd4_sub(zero, simd4_mul(nz, d)), tz);
+
+        Simd4 t_length = simd4_sqrt(simd4_dot3(tx, ty, tz, tx, ty, tz));
+        tx = simd4_div(tx, t_length);
+        ty = simd4_div(ty, t_length);
+        tz = simd4_div(tz, t_length);
+
+        /* b = cross(n, t), flipped when the UVs are mirrored */
+        Simd4 cx = simd4_sub(simd4_mul(ny, tz), simd4_mul(nz, ty));
+        Simd4 cy = simd4_sub(simd4_mul(nz, tx), simd4_mul(nx, tz));
+        Simd4 cz = simd4_sub(simd4_mul(nx, ty), simd4_mul(ny, tx));
+        Simd4 sign = simd4_select(simd4_less(simd4_dot3(cx, cy, cz, bx, by, bz), zero), simd4_splat(-1.0f), one);
+        bx = simd4_mul(cx, sign);
+        by = simd4_mul(cy, sign);
+        bz = simd4_mul(cz, sign);
+
+        /* Vertex is 14 floats: position, normal, tangent, bitangent, texcoord */
+        Simd4 px, py, pz;
+        _load_transposed(in, offsetof(SimpleVertex, position), &px, &py, &pz, &unused);
+        _store_transposed(out, 0, px, py, pz, out_nx);
+        _store_transposed(out, 4*sizeof(float), out_ny, out_nz, tx, ty);
+        _store_transposed(out, 8*sizeof(float), tz, bx, by, bz);
+        float uv[2][4];
+        simd4_store(uv[0], u);
+        simd4_store(uv[1], v);
+        for(uint32_t ll=0; ll<lanes; ++ll)
+            new_vertices[vv+ll].texcoord = vec2_create(uv[0][ll], uv[1][ll]);
+    }
+    return new_vertices;
+}
+struct int3 {
+    int p;
+    int t;
+    int n;
+
+    bool operator==(const int3 rh) const
+    {
+        return p == rh.p && t == rh.t && n == rh.n;
+    }
+};
+struct Triangle
+{
+    int3    vertex[3];
+};
+/** Open addressing (linear probing) hash table used to weld face corners into
+ *  unique vertices. One table is reused for every mesh in a file, so welding
+ *  does no per-vertex allocation. OBJ position indices start at 1, so a slot
+ *  with `key.p == 0` is empty.
+ */
+struct WeldSlot
+{
+    int3        key;
+    uint32_t    index;
+};
+struct WeldTable
+{
+    std::vector<WeldSlot>   slots;
+    uint32_t                mask;
+};
+static void _reset_weld_table(WeldTable* table, uint32_t max_entries)
+{
+    /* Keep the load factor at or below 1/2 */
+    uint32_t capacity = 16;
+    while(capacity < max_entries*2)
+        capacity *= 2;
+    if(table->slots.size() < capacity)
+        table->slots.resize(capacity);
+    memset(&table->slots[0], 0, capacity*sizeof(WeldSlot));
+    table->mask = capacity - 1;
+}
+static inline uint32_t _hash_int3(int3 key)
+{
+    uint32_t h = (uint32_t)key.p * 0x9E3779B1u;
+    h ^= (uint32_t)key.t * 0x85EBCA77u;
+    h ^= (uint32_t)key.n * 0xC2B2AE3Du;
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 13;
+    return h;
+}
+/** @return The slot holding `key`, or the empty slot it should be inserted in
+ */
+static inline WeldSlot* _find_weld_slot(WeldTable* table, int3 key)
+{
+    uint32_t slot = _hash_int3(key) & table->mask;
+    while(1) {
+        WeldSlot* s = &table->slots[slot];
+        if(s->key.p == 0 || s->key == key)
+            return s;
+        slot = (slot + 1) & table->mask;
+    }
+}
+/** Name index slots hold a position, or NAME_INDEX_NOT_FOUND when empty.
+ *  The load factor is kept at or below 1/2
+ */
+static inline const char* _name_at(const void* names, size_t stride, uint32_t position)
+{
+    return (const char*)names + position*stride;
+}
+static inline uint32_t _name_slot(const NameIndex* index, const void* names, size_t stride, const char* name)
+{
+    uint32_t mask = index->num_slots - 1;
+    uint32_t slot = (uint32_t)hash_data(name, strlen(name), 0) & mask;
+    while(1) {
+        uint32_t position = index->slots[slot];
+        if(position == NAME_INDEX_NOT_FOUND || strcmp(_name_at(names, stride, position), name) == 0)
+            return slot;
+        slot = (slot + 1) & mask;
+    }
+}
+static void _resize_name_index(NameIndex* index, const void* names, size_t stride, uint32_t num_slots)
+{
+    uint32_t* old_slots = index->slots;
+    uint32_t old_num_slots = index->num_slots;
+
+    index->slots = (uint32_t*)malloc(num_slots*sizeof(uint32_t));
+    index->num_slots = num_slots;
+    memset(index->slots, 0xFF, num_slots*sizeof(uint32_t));
+    for(uint32_t ii=0; ii<old_num_slots; ++ii) {
+        uint32_t position = old_slots[ii];
+        if(position != NAME_INDEX_NOT_FOUND)
+            index->slots[_name_slot(index, names, stride, _name_at(names, stride, position))] = position;
+    }
+    free(old_slots);
+}
+
+/** A `usemtl` group, covering a contiguous range of triangles
+ */
+struct ObjGroup
+{
+    char        name[128];
+    char        material_name[128];
+    uint32_t    first_triangle;
+    uint32_t    num_triangles;
+    int         named;
+};
+/** Parses one "p", "p/t", "p//n" or "p/t/n" face corner. Missing texture
+ *  coordinates map to the default one at index 0.
+ *  @return A pointer past the corner, NULL if it is malformed
+ */
+static inline const char* _parse_face_corner(const char* p, const char* end, int3* corner)
+{
+    corner->t = 0;
+    corner->n = 0;
+    p = _parse_int(p, end, &corner->p);
+    if(p == NULL || p == end || *p != '/')
+        return p;
+    ++p;
+    if(p < end && *p != '/') {
+        p = _parse_int(p, end, &corner->t);
+        if(p == NULL || p == end || *p != '/')
+            return p;
+    }
+    ++p;
+    return _parse_int(p, end, &corner->n);
+}
+/** Parse results for one newline-aligned range of an OBJ file. Face indices
+ *  stay the file's global 1-based indices; groups index `triangles`.
+ */
+struct ObjChunk
+{
+    const char*                 file_begin;
+    const char*                 file_end;
+    const char*                 begin;
+    const char*                 end;
+
+    std::vector<Vec3>           positions;
+    std::vector<Vec3>           normals;
+    std::vector<Vec2>           texcoords;
+    std::vector<Triangle>       triangles;
+    std::vector<ObjGroup>       groups;
+    std::vector<std::string>    mtl_filenames;
+    int                         error;
+
+    /* Where this chunk's data goes in the merged arrays */
+    size_t                      position_offset;
+    size_t                      normal_offset;
+    size_t                      texcoord_offset;
+    size_t                      triangle_offset;
+};
+/** Merged parse results for a whole OBJ file
+ */
+struct ObjData
+{
+    std::vector<Vec3>       positions;
+    std::vector<Vec3>       normals;
+    std::vector<Vec2>       texcoords;
+    std::vector<Triangle>   triangles;
+    std::vector<ObjGroup>   groups;
+};
+struct ObjMerge
+{
+    ObjChunk*   chunks;
+    ObjData*    data;
+};
+
+/** Minimum number of bytes worth handing to another thread */
+static const size_t kMinObjChunkSize = 1024*1024;
+/** Number of threads to parse with. 0 uses one per CPU */
+static int s_load_threads = 0;
+
+/** @return The start of the line before `line`, NULL if there is none
+ */
+static const char* _previous_line(const char* file_begin, const char* line)
+{
+    const char* p = line;
+    if(p == file_begin)
+        return NULL;
+    --p;
+    if(*p == '\n' && p > file_begin && *(p-1) == '\r')
+        --p;
+    while(p > file_begin && *(p-1) != '\n' && *(p-1) != '\r')
+        --p;
+    return p;
+}
+/** Parses every line starting in [chunk->begin, chunk->end). Lines around the
+ *  range are only peeked at, for `g` names next to a `usemtl`.
+ */
+static void _parse_obj_chunk(ObjChunk* chunk)
+{
+    const char* end = chunk->file_end;
+    const char* prev_line = _previous_line(chunk->file_begin, chunk->begin);
+    const char* line = chunk->begin;
+    while(line < chunk->end) {
+        const char* next_line = _skip_line(line, end);
+        const char* header = _skip_space(line, next_line);
+        const char* header_end = _skip_token(header, next_line);
+        const char* p = header_end;
+
+        if(_token_is(header, header_end, "v")) {
+            Vec3 v = vec3_zero;
+            p = _parse_float(p, next_line, &v.x);
+            if(p) p = _parse_float(p, next_line, &v.y);
+            if(p) p = _parse_float(p, next_line, &v.z);
+            assert(p);
+            chunk->positions.push_back(v);
+        } else if(_token_is(header, header_end, "vt")) {
+            Vec2 t = vec2_zero;
+            p = _parse_float(p, next_line, &t.x);
+            if(p) p = _parse_float(p, next_line, &t.y);
+            assert(p);
+            chunk->texcoords.push_back(t);
+        } else if(_token_is(header, header_end, "vn")) {
+            Vec3 n = vec3_zero;
+            p = _parse_float(p, next_line, &n.x);
+            if(p) p = _parse_float(p, next_line, &n.y);
+            if(p) p = _parse_float(p, next_line, &n.z);
+            assert(p);
+            chunk->normals.push_back(n);
+        } else if(_token_is(header, header_end, "f")) {
+            int3 first = {0,0,0};
+            int3 prev = {0,0,0};
+            int num_corners = 0;
+            while(1) {
+                int3 corner;
+                p = _skip_space(p, next_line);
+                if(p == next_line || _is_end_of_line(*p))
+                    break;
+                p = _parse_face_corner(p, next_line, &corner);
+                if(p == NULL || corner.n == 0) {
+                    chunk->error = 1;
+                    return;
+                }
+                /* Fan out triangles and quads (and any larger polygon) */
+                if(num_corners == 0) {
+                    first = corner;
+                } else if(num_corners >= 2) {
+                    Triangle tri = {
+                        { first, prev, corner }
+                    };
+                    chunk->triangles.push_back(tri);
+                }
+                prev = corner;
+                ++num_corners;
+            }
+            if(num_corners < 3) {
+                chunk->error = 1;
+                return;
+            }
+        } else if(_token_is(header, header_end, "usemtl")) {
+            ObjGroup group;
+            memset(&group, 0, sizeof(group));
+            _copy_token(group.material_name, sizeof(group.material_name), p, next_line);
+            // Check to see if this is named (a 'g' on the next or prev line)
+            if(prev_line && prev_line[0] == 'g') {
+                _copy_token(group.name, sizeof(group.name), _skip_token(prev_line, line), line);
+                group.named = 1;
+            } else if(next_line < end && next_line[0] == 'g') {
+                const char* name_line_end = _skip_line(next_line, end);
+                _copy_token(group.name, sizeof(group.name), _skip_token(next_line, name_line_end), name_line_end);
+                group.named = 1;
+            }
+            group.first_triangle = (uint32_t)chunk->triangles.size();
+            chunk->groups.push_back(group);
+        } else if(_token_is(header, header_end, "mtllib")) {
+            char mtl_filename[256];
+            _copy_token(mtl_filename, sizeof(mtl_filename), p, next_line);
+            chunk->mtl_filenames.push_back(mtl_filename);
+        }
+        prev_line = line;
+        line = next_line;
+    }
+}
+static void _parse_obj_chunk_task(void* data, int index, int thread)
+{
+    (void)thread;
+    _parse_obj_chunk((ObjChunk*)data + index);
+}
+template<typename T>
+static void _copy_into(std::vector<T>* dest, size_t offset, std::vector<T>* src)
+{
+    if(!src->empty())
+        memcpy(&(*dest)[offset], &(*src)[0], src->size()*sizeof(T));
+    std::vector<T>().swap(*src);
+}
+static void _merge_obj_chunk_task(void* data, int index, int thread)
+{
+    ObjMerge* merge = (ObjMerge*)data;
+    ObjChunk* chunk = merge->chunks + index;
+    (void)thread;
+    _copy_into(&merge->data->positions, chunk->position_offset, &chunk->positions);
+    _copy_into(&merge->data->normals, chunk->normal_offset, &chunk->normals);
+    _copy_into(&merge->data->texcoords, chunk->texcoord_offset, &chunk->texcoords);
+    _copy_into(&merge->data->triangles, chunk->triangle_offset, &chunk->triangles);
+}
+/** Parses an OBJ file, split into newline-aligned chunks that are parsed in
+ *  parallel and then stitched back together in file order. Referenced MTL
+ *  files are loaded into `scene` in the order they appear.
+ *  @return 0 on success, -1 for a malformed file
+ */
+static int _parse_obj(const char* path, const char* file_data, size_t file_size,
+                      SceneData* scene, ObjData* obj)
+{
+    const char* file_end = file_data + file_size;
+    int num_threads = s_load_threads > 0 ? s_load_threads : num_cpu_threads();
+    size_t num_chunks = 1;
+    size_t ii;
+
+    /* A few chunks per thread to even out the load between threads */
+    if(num_threads > 1) {
+        num_chunks = num_threads*4;
+        if(num_chunks > file_size/kMinObjChunkSize)
+            num_chunks = file_size/kMinObjChunkSize;
+        if(num_chunks < 1)
+            num_chunks = 1;
+    }
+
+    //
+    // Split into chunks, on line boundaries
+    //
+    std::vector<ObjChunk> chunks(num_chunks);
+    const char* chunk_begin = file_data;
+    for(ii=0; ii<num_chunks; ++ii) {
+        const char* chunk_end = file_end;
+        if(ii+1 < num_chunks) {
+            chunk_end = file_data + file_size/num_chunks*(ii+1);
+            if(chunk_end < chunk_begin)
+                chunk_end = chunk_begin;
+            chunk_end = _skip_line(chunk_end, file_end);
+        }
+        chunks[ii].file_begin = file_data;
+        chunks[ii].file_end = file_end;
+        chunks[ii].begin = chunk_begin;
+        chunks[ii].end = chunk_end;
+        chunks[ii].error = 0;
+        chunk_begin = chunk_end;
+    }
+
+    //
+    // Parse
+    //
+    parallel_for(num_threads, (int)num_chunks, _parse_obj_chunk_task, &chunks[0]);
+
+    //
+    // Prefix sum the chunk sizes. The default texture coordinate is index 0
+    //
+    size_t num_positions = 0;
+    size_t num_normals = 0;
+    size_t num_texcoords = 1;
+    size_t num_triangles = 0;
+    for(ii=0; ii<num_chunks; ++ii) {
+        ObjChunk& chunk = chunks[ii];
+        if(chunk.error)
+            return -1;
+        chunk.position_offset = num_positions;
+        chunk.normal_offset = num_normals;
+        chunk.texcoord_offset = num_texcoords;
+        chunk.triangle_offset = num_triangles;
+        num_positions += chunk.positions.size();
+        num_normals += chunk.normals.size();
+        num_texcoords += chunk.texcoords.size();
+        num_triangles += chunk.triangles.size();
+
+        for(size_t jj=0; jj<chunk.mtl_filenames.size(); ++jj)
+            _load_mtl_file(path, chunk.mtl_filenames[jj].c_str(), scene);
+        for(size_t jj=0; jj<chunk.groups.size(); ++jj) {
+            ObjGroup group = chunk.groups[jj];
+            group.first_triangle += (uint32_t)chunk.triangle_offset;
+            if(!group.named) {
+                std::ostringstream s;
+                s << "mesh";
+                s << scene->num_meshes + obj->groups.size();
+                strncpy(group.name, s.str().c_str(), sizeof(group.name)-1);
+            }
+            obj->groups.push_back(group);
+        }
+    }
+    for(ii=0; ii<obj->groups.size(); ++ii) {
+        uint32_t next_first = (ii+1 < obj->groups.size()) ? obj->groups[ii+1].first_triangle : (uint32_t)num_triangles;
+        obj->groups[ii].num_triangles = next_first - obj->groups[ii].first_triangle;
+    }
+
+    //
+    // Merge
+    //
+    Vec2 tex = {0.5f, 0.5f};
+    ObjMerge merge = { &chunks[0], obj };
+    obj->positions.resize(num_positions);
+    obj->normals.resize(num_normals);
+    obj->texcoords.resize(num_texcoords);
+    obj->texcoords[0] = tex;
+    obj->triangles.resize(num_triangles);
+    parallel_for(num_threads, (int)num_chunks, _merge_obj_chunk_task, &merge);
+    return 0;
+}
+/** Per-thread scratch space for building meshes, reused from mesh to mesh
+ */
+struct MeshScratch
+{
+    WeldTable                   table;
+    std::vector<SimpleVertex>   vertices;
+    std::vector<uint32_t>       indices;
+    std::vector<float>          tangents;
+    double                      weld_time;
+    double                      tangent_time;
+
+    MeshScratch() : weld_time(0), tangent_time(0) {}
+};
+struct MeshBuild
+{
+    const ObjData*  obj;
+    MeshData*       meshes;
+    MeshScratch*    scratch;
+};
+/** Welds a group's face corners into unique vertices, then generates tangents
+ */
+static void _build_mesh(const ObjData* obj, const ObjGroup* group, MeshData* mesh, MeshScratch* scratch)
+{
+    const Triangle* mesh_triangles = group->num_triangles == 0 ? NULL : &obj->triangles[group->first_triangle];
+    WeldTable* m = &scratch->table;
+    std::vector<SimpleVertex>& v = scratch->vertices;
+    std::vector<uint32_t>& i = scratch->indices;
+    Timer* timer = create_timer();
+
+    _reset_weld_table(m, group->num_triangles*3);
+    v.clear();
+    i.clear();
+    v.reserve(group->num_triangles*3);
+    i.reserve(group->num_triangles*3);
+
+    for(uint32_t jj=0;jj<group->num_triangles;++jj) {
+        const Triangle& triangle = mesh_triangles[jj];
+        for(uint32_t ii=0;ii<3;++ii) {
+            int3 index = triangle.vertex[ii];
+            WeldSlot* slot = _find_weld_slot(m, index);
+            if(slot->key.p != 0) {
+                /* Already exists */
+                i.push_back(slot->index);
+            } else {
+                /* Add it */
+                int pos_index = index.p-1;
+                int tex_index = index.t;
+                int norm_index = index.n-1;
+                SimpleVertex vertex;
+                vertex.position = obj->positions[pos_index];
+                vertex.texcoord = obj->texcoords[tex_index];
+                vertex.normal = obj->normals[norm_index];
+                /* Flip v-channel */
+                vertex.texcoord.y = 1.0f-vertex.texcoord.y;
+
+                i.push_back((uint32_t)v.size());
+                slot->key = index;
+                slot->index = (uint32_t)v.size();
+                v.push_back(vertex);
+            }
+        }
+    }
+
+    scratch->weld_time += get_delta_time(timer);
+
+    mesh->vertex_count = (uint32_t)v.size();
+    mesh->index_count = (uint32_t)i.size();
+    mesh->vertices = _calculate_tangents(v.empty() ? NULL : &v[0], mesh->vertex_count,
+                                         i.empty() ? NULL : &i[0], mesh->index_count, &scratch->tangents);
+    mesh->indices = (uint32_t*)calloc(sizeof(uint32_t), mesh->index_count);
+    if(!i.empty())
+        memcpy(mesh->indices, &i[0], mesh->index_count*sizeof(uint32_t));
+    scratch->tangent_time += get_delta_time(timer);
+    destroy_timer(timer);
+}
+static void _build_mesh_task(void* data, int index, int thread)
+{
+    MeshBuild* build = (MeshBuild*)data;
+    _build_mesh(build->obj, &build->obj->groups[index], build->meshes + index, build->scratch + thread);
+}
+/*
+ * Streaming OBJ loading
+ *
+ * With a memory limit set, the file is read through a window of whole
+ * blocks instead of being loaded in one piece. Vertex attributes have to be
+ * kept (faces can index any earlier one), but the triangles of a group are
+ * welded into their final mesh as soon as the group ends and then dropped,
+ * so peak memory is the attributes, the largest group and the finished
+ * meshes rather than a multiple of the file size. A load that needs more
+ * than the limit, or has a line longer than it, fails.
+ */
+/** Memory budget for streaming OBJ loads, 0 loads files whole */
+static size_t s_load_memory_limit = 0;
+/** Timings and memory use of the last OBJ load */
+static SceneLoadStats s_load_stats;
+
+struct ObjStream
+{
+    SceneData*  scene;
+    ObjData     obj;
+    ObjGroup    group;
+    int         group_open;
+    MeshScratch scratch;
+    size_t      buffer_bytes;
+    size_t      mesh_bytes;
+};
+template<typename T>
+static size_t _capacity_bytes(const std::vector<T>& v)
+{
+    return v.capacity()*sizeof(T);
+}
+static size_t _obj_data_bytes(const ObjData& obj)
+{
+    return _capacity_bytes(obj.positions) + _capacity_bytes(obj.normals) +
+           _capacity_bytes(obj.texcoords) + _capacity_bytes(obj.triangles) +
+           _capacity_bytes(obj.groups);
+}
+/** @return 0 while the load fits in the memory limit, -1 once it doesn't
+ */
+static int _track_obj_stream_memory(ObjStream* stream, const ObjChunk* chunk)
+{
+    size_t bytes = stream->buffer_bytes + stream->mesh_bytes + _obj_data_bytes(stream->obj) +
+                   _capacity_bytes(chunk->positions) + _capacity_bytes(chunk->normals) +
+                   _capacity_bytes(chunk->texcoords) + _capacity_bytes(chunk->triangles) +
+                   _capacity_bytes(stream->scratch.table.slots) +
+                   _capacity_bytes(stream->scratch.vertices) + _capacity_bytes(stream->scratch.indices) +
+                   _capacity_bytes(stream->scratch.tangents);
+    if(bytes > s_load_stats.peak_memory)
+        s_load_stats.peak_memory = bytes;
+    if(bytes > s_load_memory_limit) {
+        system_log("OBJ loading needs %lu bytes, more than the %lu byte limit\n",
+                   (unsigned long)bytes, (unsigned long)s_load_memory_limit);
+        return -1;
+    }
+    return 0;
+}
+/** Welds the open group into a mesh and model, then drops its triangles
+ *  @return -1 if that went over the memory limit
+ */
+static int _finish_obj_stream_group(ObjStream* stream, const ObjChunk* chunk)
+{
+    int result = 0;
+    SceneData* scene = stream->scene;
+    ObjGroup& group = stream->group;
+    if(stream->group_open) {
+        if(!group.named) {
+            std::ostringstream s;
+            s << "mesh";
+            s << scene->num_meshes;
+            strncpy(group.name, s.str().c_str(), sizeof(group.name)-1);
+        }
+        group.first_triangle = 0;
+        group.num_triangles = (uint32_t)stream->obj.triangles.size();
+
+        scene->num_meshes++;
+        scene->num_models++;
+        scene->meshes = (MeshData*)realloc(scene->meshes, sizeof(MeshData)*scene->num_meshes);
+        scene->models = (ModelData*)realloc(scene->models, sizeof(ModelData)*scene->num_models);
+        MeshData* mesh = scene->meshes + scene->num_meshes - 1;
+        ModelData* model = scene->models + scene->num_models - 1;
+        memset(mesh, 0, sizeof(*mesh));
+        memset(model, 0, sizeof(*model));
+        strncpy(mesh->name, group.name, sizeof(mesh->name)-1);
+        strncpy(model->mesh_name, mesh->name, sizeof(model->mesh_name));
+        strncpy(model->material_name, group.material_name, sizeof(model->material_name));
+
+        _build_mesh(&stream->obj, &group, mesh, &stream->scratch);
+        s_load_stats.num_vertices += mesh->vertex_count;
+        s_load_stats.num_triangles += mesh->index_count/3;
+        stream->mesh_bytes += mesh->vertex_count*sizeof(Vertex) + mesh->index_count*sizeof(uint32_t);
+        result = _track_obj_stream_memory(stream, chunk);
+    }
+    stream->obj.triangles.clear();
+    return result;
+}
+/** Moves one window's parse results into the stream, finishing every group
+ *  that ended inside it
+ *  @return -1 if that went over the memory limit
+ */
+static int _consume_obj_chunk(ObjStream* stream, ObjChunk* chunk, const char* path)
+{
+    ObjData& obj = stream->obj;
+    obj.positions.insert(obj.positions.end(), chunk->positions.begin(), chunk->positions.end());
+    obj.normals.insert(obj.normals.end(), chunk->normals.begin(), chunk->normals.end());
+    obj.texcoords.insert(obj.texcoords.end(), chunk->texcoords.begin(), chunk->texcoords.end());
+    for(size_t ii=0; ii<chunk->mtl_filenames.size(); ++ii)
+        _load_mtl_file(path, chunk->mtl_filenames[ii].c_str(), stream->scene);
+
+    /* Triangles before the first group don't belong to any mesh */
+    size_t first = 0;
+    for(size_t ii=0; ii<chunk->groups.size(); ++ii) {
+        size_t last = chunk->groups[ii].first_triangle;
+        if(stream->group_open)
+            obj.triangles.insert(obj.triangles.end(), chunk->triangles.begin() + first, chunk->triangles.begin() + last);
+        first = last;
+        if(_finish_obj_stream_group(stream, chunk) != 0)
+            return -1;
+        stream->group = chunk->groups[ii];
+        stream->group_open = 1;
+    }
+    if(stream->group_open)
+        obj.triangles.insert(obj.triangles.end(), chunk->triangles.begin() + first, chunk->triangles.end());
+    if(_track_obj_stream_memory(stream, chunk) != 0)
+        return -1;
+
+    chunk->positions.clear();
+    chunk->normals.clear();
+    chunk->texcoords.clear();
+    chunk->triangles.clear();
+    chunk->groups.clear();
+    chunk->mtl_filenames.clear();
+    return 0;
+}
+/** @return The end of the last complete line in [data, end), NULL if there
+ *  is none. A trailing '\r' may still be followed by a '\n'.
+ */
+static const char* _last_line_end(const char* data, const char* end)
+{
+    const char* p = end;
+    if(p > data && *(p-1) == '\r')
+        --p;
+    while(p > data && *(p-1) != '\n' && *(p-1) != '\r')
+        --p;
+    return p > data ? p : NULL;
+}
+static int _load_obj_streaming(const char* path, const char* filename, SceneData* scene)
+{
+    std::string full_filename = std::string(path) + filename;
+    FileStream* file = open_file_stream(full_filename.c_str());
+    if(file == NULL)
+        return -1;
+
+    /* List the OBJ before its MTLs, its hash is filled in once it's all read */
+    uint32_t source = scene->num_sources;
+    _add_scene_source(scene, full_filename.c_str(), 0);
+
+    /* The window is a whole number of blocks, an eighth of the budget */
+    size_t window_size = s_load_memory_limit/8/kSourceBlockSize*kSourceBlockSize;
+    if(window_size < 4*kSourceBlockSize)
+        window_size = 4*kSourceBlockSize;
+    if(window_size > 256*kSourceBlockSize)
+        window_size = 256*kSourceBlockSize;
+
+    std::vector<char> buffer(window_size);
+    size_t data_size = 0;
+    size_t begin = 0;
+    uint64_t hash = 0;
+    int end_of_file = 0;
+    int result = 0;
+
+    ObjStream stream;
+    memset(&stream.group, 0, sizeof(stream.group));
+    stream.scene = scene;
+    stream.group_open = 0;
+    stream.mesh_bytes = 0;
+    Vec2 tex = {0.5f, 0.5f};
+    stream.obj.texcoords.push_back(tex);
+
+    ObjChunk chunk;
+    chunk.error = 0;
+    while(1) {
+        /* Top up the window a block at a time, hashing the source as it goes */
+        while(!end_of_file && buffer.size() - data_size >= kSourceBlockSize) {
+            size_t size = read_file_stream(file, &buffer[data_size], kSourceBlockSize);
+            hash = _hash_source_block(&buffer[data_size], size, hash);
+            data_size += size;
+            s_load_stats.file_size += size;
+            end_of_file = size < kSourceBlockSize;
+        }
+        stream.buffer_bytes = buffer.capacity();
+
+        /* Parse every complete line but the last, which is kept so a 'g'
+         * after a 'usemtl' is visible. Everything is parsed at the end */
+        const char* data = &buffer[0];
+        const char* data_end = data + data_size;
+        const char* limit = data_end;
+        if(!end_of_file) {
+            const char* line_end = _last_line_end(data, data_end);
+            limit = line_end ? _previous_line(data, line_end) : NULL;
+            if(limit == NULL || limit <= data + begin) {
+                /* A line longer than the window, which may grow up to the limit */
+                if(buffer.size() >= s_load_memory_limit) {
+                    system_log("OBJ line longer than the %lu byte limit\n", (unsigned long)s_load_memory_limit);
+                    result = -1;
+                    break;
+                }
+                size_t grown = buffer.size()*2;
+                buffer.resize(grown < s_load_memory_limit ? grown : s_load_memory_limit);
+                continue;
+            }
+            data_end = line_end;
+        }
+        chunk.file_begin = data;
+        chunk.file_end = data_end;
+        chunk.begin = data + begin;
+        chunk.end = limit;
+        _parse_obj_chunk(&chunk);
+        if(chunk.error) {
+            result = -1;
+            break;
+        }
+        if(_consume_obj_chunk(&stream, &chunk, path) != 0) {
+            result = -1;
+            break;
+        }
+        if(end_of_file)
+            break;
+
+        /* Keep the last parsed line for 'g' lookups, plus everything unparsed */
+        const char* keep = _previous_line(data, limit);
+        size_t keep_offset = (size_t)(keep - data);
+        memmove(&buffer[0], keep, data_size - keep_offset);
+        data_size -= keep_offset;
+        begin = (size_t)(limit - keep);
+    }
+    close_file_stream(file);
+    if(result == 0)
+        result = _finish_obj_stream_group(&stream, &chunk);
+    if(result == 0)
+        scene->sources[source].hash = hash;
+    s_load_stats.weld_time = stream.scratch.weld_time;
+    s_load_stats.tangent_time = stream.scratch.tangent_time;
+    return result;
+}
+/** @return 0 on success, -1 if the file is missing or malformed
+ */
+static int _load_obj(const char* path, const char* filename, SceneData* scene)
+{
+    std::string path_string(path);
+    ObjData obj;
+
+    char* file_data = NULL;
+    size_t file_size = 0;
+
+    Timer* timer = create_timer();
+    memset(&s_load_stats, 0, sizeof(s_load_stats));
+    if(s_load_memory_limit > 0) {
+        int result = _load_obj_streaming(path, filename, scene);
+        s_load_stats.total_time = get_running_time(timer);
+        s_load_stats.parse_time = s_load_stats.total_time - s_load_stats.weld_time - s_load_stats.tangent_time;
+        destroy_timer(timer);
+        return result;
+    }
+
+    if(load_file_data((path_string+filename).c_str(), (void**)&file_data, &file_size) != 0) {
+        destroy_timer(timer);
+        return -1;
+    }
+    _add_scene_source(scene, (path_string+filename).c_str(), _hash_source_data(file_data, file_size));
+
+    if(_parse_obj(path, file_data, file_size, scene, &obj) != 0) {
+        free_file_data(file_data);
+        destroy_timer(timer);
+        return -1;
+    }
+    free_file_data(file_data);
+    s_load_stats.parse_time = get_running_time(timer);
+    s_load_stats.file_size = file_size;
+    s_load_stats.peak_memory = file_size + _obj_data_bytes(obj);
+
+    const std::vector<ObjGroup>& groups = obj.groups;
+
+    //
+    // Create meshes
+    //
+    uint32_t num_meshes = (uint32_t)groups.size();
+    uint32_t orig_num_meshes = scene->num_meshes;
+    uint32_t orig_num_models = scene->num_models;
+    scene->num_meshes += num_meshes;
+    scene->num_models += num_meshes;
+    scene->meshes = (MeshData*)realloc(scene->meshes, sizeof(MeshData)*scene->num_meshes);
+    scene->models = (ModelData*)realloc(scene->models, sizeof(ModelData)*scene->num_models);
+
+    MeshData* current_mesh = scene->meshes + orig_num_meshes;
+    ModelData* current_model = scene->models + orig_num_models;
+
+    for(uint32_t kk=0; kk<num_meshes;++kk) {
+        memset(current_mesh, 0, sizeof(*current_mesh));
+        memset(current_model, 0, sizeof(*current_model));
+        strncpy(current_mesh->name, groups[kk].name, sizeof(current_mesh->name));
+        strncpy(current_model->mesh_name, current_mesh->name, sizeof(current_model->mesh_name));
+        strncpy(current_model->material_name, groups[kk].material_name, sizeof(current_model->material_name));
+
+        current_mesh++;
+        current_model++;
+    }
+
+    /* Every mesh is independent; each thread reuses its own scratch space */
+    int num_threads = s_load_threads > 0 ? s_load_threads : num_cpu_threads();
+    std::vector<MeshScratch> scratch(num_threads);
+    MeshBuild build = { &obj, scene->meshes + orig_num_meshes, &scratch[0] };
+    parallel_for(num_threads, (int)num_meshes, _build_mesh_task, &build);
+
+    size_t build_bytes = _obj_data_bytes(obj);
+    for(uint32_t kk=0; kk<num_meshes; ++kk) {
+        const MeshData& mesh = scene->meshes[orig_num_meshes + kk];
+        build_bytes += mesh.vertex_count*sizeof(Vertex) + mesh.index_count*sizeof(uint32_t);
+        s_load_stats.num_vertices += mesh.vertex_count;
+        s_load_stats.num_triangles += mesh.index_count/3;
+    }
+    for(size_t kk=0; kk<scratch.size(); ++kk) {
+        build_bytes += _capacity_bytes(scratch[kk].table.slots) +
+                       _capacity_bytes(scratch[kk].vertices) + _capacity_bytes(scratch[kk].indices) +
+                       _capacity_bytes(scratch[kk].tangents);
+        s_load_stats.weld_time += scratch[kk].weld_time;
+        s_load_stats.tangent_time += scratch[kk].tangent_time;
+    }
+    if(build_bytes > s_load_stats.peak_memory)
+        s_load_stats.peak_memory = build_bytes;
+    s_load_stats.total_time = get_running_time(timer);
+    destroy_timer(timer);
+    return 0;
+}
+/** Models bind to meshes by name, but an OBJ can repeat a group name (e.g.
+ *  "g default"), so repeats get a numeric suffix. Each OBJ model is made for
+ *  the mesh at the same position
+ */
+static void _make_mesh_names_unique(SceneData* scene)
+{
+    NameIndex index;
+    memset(&index, 0, sizeof(index));
+    for(uint32_t ii=0; ii<scene->num_meshes; ++ii) {
+        MeshData* mesh = scene->meshes + ii;
+        if(_add_name(&index, scene->meshes, sizeof(MeshData), ii) == ii)
+            continue;
+        std::string base(mesh->name);
+        if(base.size() > sizeof(mesh->name)-12)
+            base.resize(sizeof(mesh->name)-12);
+        for(uint32_t suffix=1; ; ++suffix) {
+            std::ostringstream s;
+            s << base << "_" << suffix;
+            memset(mesh->name, 0, sizeof(mesh->name));
+            strncpy(mesh->name, s.str().c_str(), sizeof(mesh->name)-1);
+            if(_add_name(&index, scene->meshes, sizeof(MeshData), ii) == ii)
+                break;
+        }
+        memcpy(scene->models[ii].mesh_name, mesh->name, sizeof(scene->models[ii].mesh_name));
+    }
+    _free_name_index(&index);
+}
+
+/*
+ * Scene cache
+ *
+ * Parsing, welding and generating tangents for a large OBJ dominates load
+ * time, so the resulting SceneData is written to a binary sidecar in the
+ * cache directory. Every source file (the OBJ and its MTLs) is listed with a
+ * hash of its contents; the cache is only used when all of them still match.
+ * Bump kSceneCacheVersion whenever Vertex or any of the *Data structs change.
+ *
+ *  SceneCacheHeader
+ *  SceneSource         [num_sources]
+ *  SceneCacheMesh      [num_meshes]
+ *  MaterialData        [num_materials]
+ *  ModelData           [num_models]
+ *  Vertex, uint32_t    [vertex_count], [index_count] for each mesh
+ */
+static const char kSceneCacheMagic[4] = { 'S', 'C', 'N', 'C' };
+static const uint32_t kSceneCacheVersion = 3;
+
+struct SceneCacheHeader
+{
+    char        magic[4];
+    uint32_t    version;
+    uint32_t    vertex_size;
+    uint32_t    num_sources;
+    uint32_t    num_meshes;
+    uint32_t    num_materials;
+    uint32_t    num_models;
+    uint32_t    _padding;
+};
+struct SceneCacheMesh
+{
+    char        name[128];
+    uint32_t    vertex_count;
+    uint32_t    index_count;
+};
+
+static std::string _scene_cache_filename(const char* filename)
+{
+    std::string cache_filename(filename);
+    for(size_t ii=0; ii<cache_filename.size(); ++ii) {
+        if(cache_filename[ii] == '/' || cache_filename[ii] == '\\' || cache_filename[ii] == ':')
+            cache_filename[ii] = '_';
+    }
+    return cache_filename + ".cache";
+}
+void _save_scene_cache(const char* filename, const SceneData* scene)
+{
+    SceneCacheHeader header;
+    size_t size = sizeof(header) +
+                  scene->num_sources*sizeof(SceneSource) +
+                  scene->num_meshes*sizeof(SceneCacheMesh) +
+                  scene->num_materials*sizeof(MaterialData) +
+                  scene->num_models*sizeof(ModelData);
+    for(uint32_t ii=0; ii<scene->num_meshes; ++ii)
+        size += scene->meshes[ii].vertex_count*sizeof(Vertex) + scene->meshes[ii].index_count*sizeof(uint32_t);
+
+    char* data = (char*)malloc(size);
+    char* p = data;
+    if(data == NULL)
+        return;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kSceneCacheMagic, sizeof(header.magic));
+    header.version = kSceneCacheVersion;
+    header.vertex_size = sizeof(Vertex);
+    header.num_sources = scene->num_sources;
+    header.num_meshes = scene->num_meshes;
+    header.num_materials = scene->num_materials;
+    header.num_models = scene->num_models;
+    memcpy(p, &header, sizeof(header));
+    p += sizeof(header);
+
+    memcpy(p, scene->sources, scene->num_sources*sizeof(SceneSource));
+    p += scene->num_sources*sizeof(SceneSource);
+    for(uint32_t ii=0; ii<scene->num_meshes; ++ii) {
+        SceneCacheMesh mesh;
+        memset(&mesh, 0, sizeof(mesh));
+        memcpy(mesh.name, scene->meshes[ii].name, sizeof(mesh.name));
+        mesh.vertex_count = scene->meshes[ii].vertex_count;
+        mesh.index_count = scene->meshes[ii].index_count;
+        memcpy(p, &mesh, sizeof(mesh));
+        p += sizeof(mesh);
+    }
+    memcpy(p, scene->materials, scene->num_materials*sizeof(MaterialData));
+    p += scene->num_materials*sizeof(MaterialData);
+    memcpy(p, scene->models, scene->num_models*sizeof(ModelData));
+    p += scene->num_models*sizeof(ModelData);
+    for(uint32_t ii=0; ii<scene->num_meshes; ++ii) {
+        const MeshData& mesh = scene->meshes[ii];
+        memcpy(p, mesh.vertices, mesh.vertex_count*sizeof(Vertex));
+        p += mesh.vertex_count*sizeof(Vertex);
+        memcpy(p, mesh.indices, mesh.index_count*sizeof(uint32_t));
+        p += mesh.index_count*sizeof(uint32_t);
+    }
+    assert(p == data + size);
+
+    if(save_cache_data(_scene_cache_filename(filename).c_str(), data, size) != 0)
+        system_log("Unable to write scene cache for %s\n", filename);
+    free(data);
+}
+static int _scene_cache_sources_match(const SceneSource* sources, uint32_t num_sources)
+{
+    std::vector<char> block(kSourceBlockSize);
+    for(uint32_t ii=0; ii<num_sources; ++ii) {
+        uint64_t hash = 0;
+        size_t size;
+        char filename[sizeof(sources[ii].filename)];
+        memcpy(filename, sources[ii].filename, sizeof(filename));
+        filename[sizeof(filename)-1] = '\0';
+
+        /* Stream the source so validating a huge OBJ stays cheap on memory */
+        FileStream* file = open_file_stream(filename);
+        if(file == NULL)
+            return 0;
+        do {
+            size = read_file_stream(file, &block[0], block.size());
+            hash = _hash_source_block(&block[0], size, hash);
+        } while(size == block.size());
+        close_file_stream(file);
+        if(hash != sources[ii].hash)
+            return 0;
+    }
+    return 1;
+}
+SceneData* _load_scene_cache(const char* filename)
+{
+    void* data = NULL;
+    size_t size = 0;
+    if(load_cache_data(_scene_cache_filename(filename).c_str(), &data, &size) != 0)
+        return NULL;
+
+    const char* p = (const char*)data;
+    const char* end = p + size;
+    SceneCacheHeader header;
+    SceneData* scene = NULL;
+
+    /* Validate the header and table sizes before trusting any counts */
+    if(size < sizeof(header))
+        goto invalid;
+    memcpy(&header, p, sizeof(header));
+    p += sizeof(header);
+    if(memcmp(header.magic, kSceneCacheMagic, sizeof(header.magic)) != 0 ||
+       header.version != kSceneCacheVersion ||
+       header.vertex_size != sizeof(Vertex))
+        goto invalid;
+    if((size_t)(end - p) / sizeof(SceneSource) < header.num_sources)
+        goto invalid;
+    if(!_scene_cache_sources_match((const SceneSource*)p, header.num_sources))
+        goto invalid;
+
+    scene = (SceneData*)calloc(1, sizeof(SceneData));
+    scene->num_sources = header.num_sources;
+    scene->sources = (SceneSource*)malloc(header.num_sources*sizeof(SceneSource));
+    memcpy(scene->sources, p, header.num_sources*sizeof(SceneSource));
+    p += header.num_sources*sizeof(SceneSource);
+
+    if((size_t)(end - p) < header.num_meshes*sizeof(SceneCacheMesh) +
+                           header.num_materials*sizeof(MaterialData) +
+                           header.num_models*sizeof(ModelData))
+        goto invalid;
+    scene->meshes = (MeshData*)calloc(header.num_meshes, sizeof(MeshData));
+    for(uint32_t ii=0; ii<header.num_meshes; ++ii) {
+        SceneCacheMesh mesh;
+        memcpy(&mesh, p, sizeof(mesh));
+        p += sizeof(mesh);
+        memcpy(scene->meshes[ii].name, mesh.name, sizeof(mesh.name));
+        scene->meshes[ii].name[sizeof(mesh.name)-1] = '\0';
+        scene->meshes[ii].vertex_count = mesh.vertex_count;
+        scene->meshes[ii].index_count = mesh.index_count;
+        scene->num_meshes++;
+    }
+    scene->num_materials = header.num_materials;
+    scene->materials = (MaterialData*)malloc(header.num_materials*sizeof(MaterialData));
+    memcpy(scene->materials, p, header.num_materials*sizeof(MaterialData));
+    p += header.num_materials*sizeof(MaterialData);
+    scene->num_models = header.num_models;
+    scene->models = (ModelData*)malloc(header.num_models*sizeof(ModelData));
+    memcpy(scene->models, p, header.num_models*sizeof(ModelData));
+    p += header.num_models*sizeof(ModelData);
+
+    for(uint32_t ii=0; ii<scene->num_meshes; ++ii) {
+        MeshData& mesh = scene->meshes[ii];
+        size_t vertex_size = mesh.vertex_count*sizeof(Vertex);
+        size_t index_size = mesh.index_count*sizeof(uint32_t);
+        if((size_t)(end - p) < vertex_size + index_size)
+            goto invalid;
+        mesh.vertices = (Vertex*)malloc(vertex_size);
+        mesh.indices = (uint32_t*)malloc(index_size);
+        memcpy(mesh.vertices, p, vertex_size);
+        p += vertex_size;
+        memcpy(mesh.indices, p, index_size);
+        p += index_size;
+    }
+    if(p != end)
+        goto invalid;
+
+    free(data);
+    return scene;
+
+invalid:
+    if(scene)
+        _free_scene_data(scene);
+    free(data);
+    return NULL;
+}
+
+/*
+ * .scene files
+ *
+ * Line based text listing the .mesh files to load, then any number of model
+ * instances and lights. Meshes and materials are numbered in load order
+ * across all mesh_file lines, so a prop is uploaded once no matter how many
+ * times it is placed. A material of -1 uses the one the mesh was exported
+ * with. Paths are relative to the .scene file.
+ *
+ *  # comment
+ *  mesh_file   props.mesh
+ *  model       <mesh> <material> <px py pz> <qx qy qz qw> <scale>
+ *  light       <px py pz> <r g b> <size>
+ */
+static const char* _parse_floats(const char* p, const char* end, float* values, int count)
+{
+    for(int ii=0; ii<count && p; ++ii)
+        p = _parse_float(p, end, values + ii);
+    return p;
+}
+
+/* External functions
+ */
+SceneData* _load_scene_data(const char* filename)
+{
+    char path[256] = {0};
+    char file[256] = {0};
+    split_filename(path, sizeof(path), file, sizeof(file), filename);
+
+    SceneData* data = (SceneData*)calloc(1, sizeof(SceneData));
+    if(_load_obj(path, file, data) != 0) {
+        system_log("Can't load %s\n", filename);
+        _free_scene_data(data);
+        return NULL;
+    }
+    _make_mesh_names_unique(data);
+    return data;
+}
+void _print_scene_data(const SceneData* scene)
+{
+    printf("Num meshes:\t%d\n", scene->num_meshes);
+    for(uint32_t ii=0; ii<scene->num_meshes;++ii) {
+        _print_mesh_data(scene->meshes + ii);
+    }
+    printf("Num Materials:\t%d\n", scene->num_materials);
+    for(uint32_t ii=0; ii<scene->num_materials;++ii) {
+        _print_material_data(scene->materials + ii);
+    }
+    printf("Num models:\t%d\n", scene->num_models);
+    for(uint32_t ii=0; ii<scene->num_models;++ii) {
+        _print_model_data(scene->models + ii);
+    }
+}
+void set_scene_load_threads(int num_threads)
+{
+    s_load_threads = num_threads;
+}
+void set_scene_load_memory_limit(size_t max_bytes)
+{
+    s_load_memory_limit = max_bytes;
+}
+void get_scene_load_stats(SceneLoadStats* stats)
+{
+    *stats = s_load_stats;
+}
+void _free_scene_data(SceneData* S)
+{
+    for(uint32_t ii=0;ii<S->num_meshes;++ii) {
+        free(S->meshes[ii].indices);
+        free(S->meshes[ii].vertices);
+    }
+    free(S->meshes);
+    free(S->materials);
+    free(S->models);
+    free(S->sources);
+    free(S);
+}
+void _build_name_index(NameIndex* index, const void* names, size_t stride, uint32_t count)
+{
+    uint32_t num_slots = 16;
+    while(num_slots < count*2)
+        num_slots *= 2;
+    memset(index, 0, sizeof(*index));
+    _resize_name_index(index, names, stride, num_slots);
+    for(uint32_t ii=0; ii<count; ++ii)
+        _add_name(index, names, stride, ii);
+}
+uint32_t _add_name(NameIndex* index, const void* names, size_t stride, uint32_t position)
+{
+    if((index->count+1)*2 > index->num_slots)
+        _resize_name_index(index, names, stride, index->num_slots ? index->num_slots*2 : 16);
+    uint32_t slot = _name_slot(index, names, stride, _name_at(names, stride, position));
+    if(index->slots[slot] != NAME_INDEX_NOT_FOUND)
+        return index->slots[slot];
+    index->slots[slot] = position;
+    ++index->count;
+    return position;
+}
+uint32_t _find_name(const NameIndex* index, const void* names, size_t stride, const char* name)
+{
+    if(index->num_slots == 0)
+        return NAME_INDEX_NOT_FOUND;
+    return index->slots[_name_slot(index, names, stride, name)];
+}
+void _free_name_index(NameIndex* index)
+{
+    free(index->slots);
+    memset(index, 0, sizeof(*index));
+}
+SceneFileData* _load_scene_file_data(const char* filename)
+{
+    char path[256] = {0};
+    char file[256] = {0};
+    char* file_data = NULL;
+    size_t file_size = 0;
+    std::vector<std::string> mesh_files;
+    std::vector<SceneInstanceData> instances;
+    std::vector<Light> lights;
+    int line_number = 0;
+    int result = 0;
+
+    split_filename(path, sizeof(path), file, sizeof(file), filename);
+    if(load_file_data(filename, (void**)&file_data, &file_size) != 0) {
+        system_log("Unable to open %s\n", filename);
+        return NULL;
+    }
+
+    const char* end = file_data + file_size;
+    const char* line = file_data;
+    while(line < end && result == 0) {
+        const char* next_line = _skip_line(line, end);
+        const char* header = _skip_space(line, next_line);
+        const char* header_end = _skip_token(header, next_line);
+        const char* p = header_end;
+        ++line_number;
+
+        if(header == header_end || *header == '#') {
+            /* Blank line or comment */
+        } else if(_token_is(header, header_end, "mesh_file")) {
+            char mesh_filename[256];
+            _copy_token(mesh_filename, sizeof(mesh_filename), p, next_line);
+            mesh_files.push_back(std::string(path) + mesh_filename);
+        } else if(_token_is(header, header_end, "model")) {
+            SceneInstanceData instance;
+            int mesh = -1;
+            int material = -1;
+            float values[8];
+            p = _parse_int(_skip_space(p, next_line), next_line, &mesh);
+            p = p ? _parse_int(_skip_space(p, next_line), next_line, &material) : NULL;
+            p = p ? _parse_floats(p, next_line, values, 8) : NULL;
+            if(p == NULL || mesh < 0 || material < -1) {
+                result = -1;
+            } else {
+                instance.mesh = (uint32_t)mesh;
+                instance.material = material;
+                instance.transform.position = vec3_create(values[0], values[1], values[2]);
+                instance.transform.orientation = quat_normalize(vec4_create(values[3], values[4], values[5], values[6]));
+                instance.transform.scale = values[7];
+                instances.push_back(instance);
+            }
+        } else if(_token_is(header, header_end, "light")) {
+            Light light;
+            float values[7];
+            p = _parse_floats(p, next_line, values, 7);
+            if(p == NULL) {
+                result = -1;
+            } else {
+                light.position = vec3_create(values[0], values[1], values[2]);
+                light.color = vec3_create(values[3], values[4], values[5]);
+                light.size = values[6];
+                lights.push_back(light);
+            }
+        } else {
+            result = -1;
+        }
+
+        if(result != 0)
+            system_log("%s(%d): can't parse this line\n", filename, line_number);
+        line = next_line;
+    }
+    free_file_data(file_data);
+    if(result != 0)
+        return NULL;
+
+    SceneFileData* data = (SceneFileData*)calloc(1, sizeof(SceneFileData));
+    data->num_mesh_files = (uint32_t)mesh_files.size();
+    data->mesh_files = (SceneFilename*)calloc(mesh_files.size(), sizeof(SceneFilename));
+    for(size_t ii=0; ii<mesh_files.size(); ++ii)
+        strncpy(data->mesh_files[ii].filename, mesh_files[ii].c_str(), sizeof(data->mesh_files[ii].filename)-1);
+    data->num_instances = (uint32_t)instances.size();
+    data->instances = (SceneInstanceData*)calloc(instances.size(), sizeof(SceneInstanceData));
+    for(size_t ii=0; ii<instances.size(); ++ii)
+        data->instances[ii] = instances[ii];
+    data->num_lights = (uint32_t)lights.size();
+    data->lights = (Light*)calloc(lights.size(), sizeof(Light));
+    for(size_t ii=0; ii<lights.size(); ++ii)
+        data->lights[ii] = lights[ii];
+    return data;
+}
+void _free_scene_file_data(SceneFileData* S)
+{
+    free(S->mesh_files);
+    free(S->instances);
+    free(S->lights);
+    free(S);
+}
@@ -0,0 +1,154 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __scene_data_h__
+#define __scene_data_h__
+
+#include <stdint.h>
+#include "scene.h"
+#include "vertex.h"
+
+/* The scene as loaded from disk, before any GPU resources are created. Shared
+ * by create_scene and the exporter.
+ */
+
+/** Mesh data
+ */
+typedef struct MeshData
+{
+    char        name[128];
+    Vertex*     vertices;
+    uint32_t*   indices;
+    uint32_t    vertex_count;
+    uint32_t    index_count;
+} MeshData;
+
+/** Material data
+ */
+typedef struct MaterialData
+{
+    char        name[128];
+    char        albedo_tex[128];
+    char        normal_tex[128];
+    Vec3        specular_color;
+    float       specular_power;
+    float       specular_coefficient;
+} MaterialData;
+
+/** Model data
+ */
+typedef struct ModelData
+{
+    char    mesh_name[128];
+    char    material_name[128];
+} ModelData;
+
+/** A file the scene was built from, used to validate the scene cache
+ */
+typedef struct SceneSource
+{
+    char        filename[256];
+    uint64_t    hash;
+} SceneSource;
+
+/** Scene data
+ */
+struct SceneData
+{
+    MeshData*       meshes;
+    MaterialData*   materials;
+    ModelData*      models;
+    SceneSource*    sources;
+    uint32_t        num_meshes;
+    uint32_t        num_materials;
+    uint32_t        num_models;
+    uint32_t        num_sources;
+};
+
+/** Hashed index from names to positions in an array of structs that start
+ *  with a `char name[]` (MeshData, MaterialData), so binding by name doesn't
+ *  need a linear scan. Duplicate names resolve to the first position added
+ */
+typedef struct NameIndex
+{
+    uint32_t*   slots;
+    uint32_t    num_slots;
+    uint32_t    count;
+} NameIndex;
+
+#define NAME_INDEX_NOT_FOUND 0xFFFFFFFFu
+
+/** A file name in a .scene file
+ */
+typedef struct SceneFilename
+{
+    char    filename[256];
+} SceneFilename;
+
+/** A model placed by a .scene file. A material of -1 uses the mesh's own
+ */
+typedef struct SceneInstanceData
+{
+    uint32_t    mesh;
+    int32_t     material;
+    Transform   transform;
+} SceneInstanceData;
+
+/** Contents of a .scene file
+ */
+typedef struct SceneFileData
+{
+    SceneFilename*      mesh_files;
+    SceneInstanceData*  instances;
+    Light*              lights;
+    uint32_t            num_mesh_files;
+    uint32_t            num_instances;
+    uint32_t            num_lights;
+} SceneFileData;
+
+/** Parses an OBJ file and the MTL files it references
+ */
+SceneData* _load_scene_data(const char* filename);
+void _free_scene_data(SceneData* S);
+/** Prints the scene's meshes, materials and models to stdout
+ */
+void _print_scene_data(const SceneData* scene);
+
+/** Loads the cached SceneData for a source file, if the cache exists and
+ *  every file the scene was built from is unchanged
+ *  @return NULL if there is no valid cache
+ */
+SceneData* _load_scene_cache(const char* filename);
+void _save_scene_cache(const char* filename, const SceneData* scene);
+
+/** @brief Indexes the first `count` names of `names`, `stride` bytes apart
+ */
+void _build_name_index(NameIndex* index, const void* names, size_t stride, uint32_t count);
+/** @brief Adds the name at `position`, which must already be in the array
+ *  @return `position`, or the earlier position holding the same name
+ */
+uint32_t _add_name(NameIndex* index, const void* names, size_t stride, uint32_t position);
+/** @return The position of `name`, or NAME_INDEX_NOT_FOUND
+ */
+uint32_t _find_name(const NameIndex* index, const void* names, size_t stride, const char* name);
+void _free_name_index(NameIndex* index);
+
+/** @return NULL if the file can't be opened or parsed
+ */
+SceneFileData* _load_scene_file_data(const char* filename);
+void _free_scene_file_data(SceneFileData* S);
+
+#endif /* include guard */
@@ -0,0 +1,84 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __scene_format_h__
+#define __scene_format_h__
+
+#include <stdint.h>
+
+/* .mesh files
+ *
+ * Binary, little-endian container written by tools/exporter. Every section
+ * and blob starts on a kMeshFileAlignment boundary, so once the file is
+ * mapped the vertex and index data can be handed straight to create_mesh.
+ *
+ *  MeshFileHeader
+ *  MeshFileMesh        [num_meshes]     at mesh_offset
+ *  MeshFileMaterial    [num_materials]  at material_offset
+ *  Vertex, QTangentVertex or CompressedVertex (see vertex_format), uint32_t
+ *                      blobs            at each mesh's vertex/index_offset
+ *
+ * Bump kMeshFileVersion whenever Vertex or any of these structs change.
+ */
+#define MESH_FILE_NO_MATERIAL 0xFFFFFFFFu
+#define MESH_FILE_MAX_LODS 4
+
+enum
+{
+    kMeshFileVersion    = 4,
+    kMeshFileAlignment  = 16
+};
+
+typedef struct MeshFileHeader
+{
+    char        magic[4];           /* "MESH" */
+    uint32_t    version;
+    uint32_t    vertex_size;        /* get_vertex_size(vertex_format) */
+    uint32_t    vertex_format;      /* VertexFormat of every vertex blob */
+    uint32_t    num_meshes;
+    uint32_t    num_materials;
+    uint32_t    mesh_offset;
+    uint32_t    material_offset;
+    uint32_t    file_size;
+} MeshFileHeader;
+
+typedef struct MeshFileMesh
+{
+    char        name[128];
+    uint32_t    vertex_offset;
+    uint32_t    vertex_count;
+    uint32_t    index_offset;
+    uint32_t    index_count;        /* Summed over every level of detail */
+    uint32_t    material;           /* MESH_FILE_NO_MATERIAL if unbound */
+    float       position_scale[3];  /* PositionQuantization of */
+    float       position_bias[3];   /*   kVertexFormatCompressed vertices */
+    uint32_t    num_lods;
+    uint32_t    lod_index_count[MESH_FILE_MAX_LODS];    /* Consecutive, finest first */
+    float       lod_error[MESH_FILE_MAX_LODS];          /* Relative to the bounding radius */
+} MeshFileMesh;
+
+typedef struct MeshFileMaterial
+{
+    char        name[128];
+    char        albedo_tex[128];
+    char        normal_tex[128];
+    float       specular_color[3];
+    float       specular_power;
+    float       specular_coefficient;
+    uint32_t    _padding[3];
+} MeshFileMaterial;
+
+#endif /* include guard */
@@ -0,0 +1,165 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __simd_h__
+#define __simd_h__
+
+#include <stdint.h>
+#include "vec_math.h"
+
+/* Four-wide float vectors for structure-of-arrays kernels. SSE on x86, NEON
+ * on ARM when the compiler enables it, plain C everywhere else. Loads and
+ * stores don't need any alignment. Masks are all ones or all zeros per lane.
+ */
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    #include <xmmintrin.h>
+    #define SIMD_SSE 1
+    typedef __m128 Simd4;
+    typedef __m128 Simd4Mask;
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+    #define SIMD_NEON 1
+    typedef float32x4_t Simd4;
+    typedef uint32x4_t Simd4Mask;
+#else
+    #define SIMD_SCALAR 1
+    typedef struct Simd4 { float f[4]; } Simd4;
+    typedef struct Simd4Mask { uint32_t m[4]; } Simd4Mask;
+#endif
+
+/******************************************************************************\
+ * Simd4                                                                      *
+\******************************************************************************/
+#if defined(SIMD_SSE)
+
+INLINE Simd4 simd4_load(const float* p) { return _mm_loadu_ps(p); }
+INLINE void simd4_store(float* p, Simd4 v) { _mm_storeu_ps(p, v); }
+INLINE Simd4 simd4_splat(float f) { return _mm_set1_ps(f); }
+INLINE Simd4 simd4_add(Simd4 a, Simd4 b) { return _mm_add_ps(a, b); }
+INLINE Simd4 simd4_sub(Simd4 a, Simd4 b) { return _mm_sub_ps(a, b); }
+INLINE Simd4 simd4_mul(Simd4 a, Simd4 b) { return _mm_mul_ps(a, b); }
+INLINE Simd4 simd4_div(Simd4 a, Simd4 b) { return _mm_div_ps(a, b); }
+INLINE Simd4 simd4_sqrt(Simd4 v) { return _mm_sqrt_ps(v); }
+INLINE Simd4 simd4_min(Simd4 a, Simd4 b) { return _mm_min_ps(a, b); }
+INLINE Simd4 simd4_max(Simd4 a, Simd4 b) { return _mm_max_ps(a, b); }
+INLINE Simd4 simd4_abs(Simd4 v) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v); }
+INLINE Simd4Mask simd4_less(Simd4 a, Simd4 b) { return _mm_cmplt_ps(a, b); }
+INLINE Simd4Mask simd4_greater(Simd4 a, Simd4 b) { return _mm_cmpgt_ps(a, b); }
+/** @return `a` in the lanes where `mask` is set, `b` elsewhere */
+INLINE Simd4 simd4_select(Simd4Mask mask, Simd4 a, Simd4 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+/** Transposes the 4x4 matrix with rows a, b, c, d in place, turning four
+ *  loaded structures into x, y, z, w vectors and back */
+INLINE void simd4_transpose(Simd4* a, Simd4* b, Simd4* c, Simd4* d)
+{
+    _MM_TRANSPOSE4_PS(*a, *b, *c, *d);
+}
+
+#elif defined(SIMD_NEON)
+
+INLINE Simd4 simd4_load(const float* p) { return vld1q_f32(p); }
+INLINE void simd4_store(float* p, Simd4 v) { vst1q_f32(p, v); }
+INLINE Simd4 simd4_splat(float f) { return vdupq_n_f32(f); }
+INLINE Simd4 simd4_add(Simd4 a, Simd4 b) { return vaddq_f32(a, b); }
+INLINE Simd4 simd4_sub(Simd4 a, Simd4 b) { return vsubq_f32(a, b); }
+INLINE Simd4 simd4_mul(Simd4 a, Simd4 b) { return vmulq_f32(a, b); }
+INLINE Simd4 simd4_min(Simd4 a, Simd4 b) { return vminq_f32(a, b); }
+INLINE Simd4 simd4_max(Simd4 a, Simd4 b) { return vmaxq_f32(a, b); }
+INLINE Simd4 simd4_abs(Simd4 v) { return vabsq_f32(v); }
+INLINE Simd4Mask simd4_less(Simd4 a, Simd4 b) { return vcltq_f32(a, b); }
+INLINE Simd4Mask simd4_greater(Simd4 a, Simd4 b) { return vcgtq_f32(a, b); }
+INLINE Simd4 simd4_select(Simd4Mask mask, Simd4 a, Simd4 b) { return vbslq_f32(mask, a, b); }
+INLINE void simd4_transpose(Simd4* a, Simd4* b, Simd4* c, Simd4* d)
+{
+    float32x4x2_t ab = vtrnq_f32(*a, *b);
+    float32x4x2_t cd = vtrnq_f32(*c, *d);
+    *a = vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0]));
+    *b = vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1]));
+    *c = vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0]));
+    *d = vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1]));
+}
+#if defined(__aarch64__)
+INLINE Simd4 simd4_div(Simd4 a, Simd4 b) { return vdivq_f32(a, b); }
+INLINE Simd4 simd4_sqrt(Simd4 v) { return vsqrtq_f32(v); }
+#else
+/* ARMv7 has no vector divide or square root; refine the estimates instead */
+INLINE Simd4 simd4_div(Simd4 a, Simd4 b)
+{
+    Simd4 r = vrecpeq_f32(b);
+    r = vmulq_f32(vrecpsq_f32(b, r), r);
+    r = vmulq_f32(vrecpsq_f32(b, r), r);
+    return vmulq_f32(a, r);
+}
+INLINE Simd4 simd4_sqrt(Simd4 v)
+{
+    Simd4 e = vrsqrteq_f32(v);
+    e = vmulq_f32(vrsqrtsq_f32(vmulq_f32(v, e), e), e);
+    e = vmulq_f32(vrsqrtsq_f32(vmulq_f32(v, e), e), e);
+    return vbslq_f32(vcgtq_f32(v, vdupq_n_f32(0.0f)), vmulq_f32(v, e), vdupq_n_f32(0.0f));
+}
+#endif
+
+#else /* SIMD_SCALAR */
+
+INLINE Simd4 simd4_load(const float* p) { Simd4 r; int ii; for(ii=0;ii<4;++ii) r.f[ii] = p[ii]; return r; }
+INLINE void simd4_store(float* p, Simd4 v) { int ii; for(ii=0;ii<4;++ii) p[ii] = v.f[ii]; }
+INLINE Simd4 simd4_splat(float f) { Simd4 r; int ii; for(ii=0;ii<4;++ii) r.f[ii] = f; return r; }
+INLINE Simd4 simd4_add(Simd4 a, Simd4 b) { int ii; for(ii=0;ii<4;++ii) a.f[ii] += b.f[ii]; return a; }
+INLINE Simd4 simd4_sub(Simd4 a, Simd4 b) { int ii; for(ii=0;ii<4;++ii) a.f[ii] -= b.f[ii]; return a; }
+INLINE Simd4 simd4_mul(Simd4 a, Simd4 b) { int ii; for(ii=0;ii<4;++ii) a.f[ii] *= b.f[ii]; return a; }
+INLINE Simd4 simd4_div(Simd4 a, Simd4 b) { int ii; for(ii=0;ii<4;++ii) a.f[ii] /= b.f[ii]; return a; }
+INLINE Simd4 simd4_sqrt(Simd4 v) { int ii; for(ii=0;ii<4;++ii) v.f[ii] = sqrtf(v.f[ii]); return v; }
+INLINE Simd4 simd4_min(Simd4 a, Simd4 b) { int ii; for(ii=0;ii<4;++ii) a.f[ii] = fminf(a.f[ii], b.f[ii]); return a; }
+INLINE Simd4 simd4_max(Simd4 a, Simd4 b) { int ii; for(ii=0;ii<4;++ii) a.f[ii] = fmaxf(a.f[ii], b.f[ii]); return a; }
+INLINE Simd4 simd4_abs(Simd4 v) { int ii; for(ii=0;ii<4;++ii) v.f[ii] = fabsf(v.f[ii]); return v; }
+INLINE Simd4Mask simd4_less(Simd4 a, Simd4 b)
+{
+    Simd4Mask r; int ii;
+    for(ii=0;ii<4;++ii) r.m[ii] = a.f[ii] < b.f[ii] ? 0xFFFFFFFFu : 0;
+    return r;
+}
+INLINE Simd4Mask simd4_greater(Simd4 a, Simd4 b) { return simd4_less(b, a); }
+INLINE Simd4 simd4_select(Simd4Mask mask, Simd4 a, Simd4 b)
+{
+    int ii;
+    for(ii=0;ii<4;++ii) a.f[ii] = mask.m[ii] ? a.f[ii] : b.f[ii];
+    return a;
+}
+INLINE void simd4_transpose(Simd4* a, Simd4* b, Simd4* c, Simd4* d)
+{
+    Simd4* rows[4];
+    int ii, jj;
+    rows[0] = a, rows[1] = b, rows[2] = c, rows[3] = d;
+    for(ii=0;ii<4;++ii) {
+        for(jj=ii+1;jj<4;++jj) {
+            float t = rows[ii]->f[jj];
+            rows[ii]->f[jj] = rows[jj]->f[ii];
+            rows[jj]->f[ii] = t;
+        }
+    }
+}
+
+#endif
+
+/* Three-component helpers on SoA x, y, z vectors */
+INLINE Simd4 simd4_dot3(Simd4 ax, Simd4 ay, Simd4 az, Simd4 bx, Simd4 by, Simd4 bz)
+{
+    return simd4_add(simd4_add(simd4_mul(ax, bx), simd4_mul(ay, by)), simd4_mul(az, bz));
+}
+
+#endif /* include guard */
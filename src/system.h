@@ -19,10 +19,35 @@
 
 #include <stddef.h>
 
+typedef struct FileStream FileStream;
+
 /** @return 0 on success, -1 on failure
  */
 int load_file_data(const char* filename, void** data, size_t* data_size);
 void free_file_data(void* data);
+/** Maps a file read-only into memory, without copying it where the platform
+ *  allows. The returned handle must be passed to unmap_file_data.
+ *  @return 0 on success, -1 on failure
+ */
+int map_file_data(const char* filename, const void** data, size_t* data_size, void** handle);
+void unmap_file_data(void* handle);
+/** Reads a file sequentially, for files too large to load in one piece
+ *  @return NULL on failure
+ */
+FileStream* open_file_stream(const char* filename);
+/** @return The number of bytes read, less than `size` only at the end of the
+ *  file
+ */
+size_t read_file_stream(FileStream* stream, void* buffer, size_t size);
+void close_file_stream(FileStream* stream);
+/** Cache files live in a writable, per-application directory. They can
+ *  disappear at any time, so callers must be able to rebuild them.
+ *  @return 0 on success, -1 on failure (including a missing file)
+ */
+int load_cache_data(const char* filename, void** data, size_t* data_size);
+/** @return 0 on success, -1 on failure
+ */
+int save_cache_data(const char* filename, const void* data, size_t data_size);
 /** Prints a message to the systems log
  */
 void system_log(const char* format, ...);
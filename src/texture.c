@@ -18,21 +18,68 @@
 #include "system.h"
 #include "external/stb_image.h"
 #include "gl_include.h"
+#include "utility.h"
+#include <stdlib.h>
+#include <string.h>
 
 /* Defines
  */
 
 /* Types
  */
+typedef struct CachedTexture
+{
+    char        filename[256];
+    uint64_t    hash;
+    Texture     texture;
+    int         ref_count;
+} CachedTexture;
 
 /* Constants
  */
 
 /* Variables
  */
+static CachedTexture*   s_textures = NULL;
+static int              s_num_textures = 0;
+static int              s_max_textures = 0;
 
 /* Internal functions
  */
+/** Normalizes a path so different spellings of the same file share a cache
+ *  entry: backslashes become slashes, "./" components and repeated slashes
+ *  are dropped
+ */
+static void _resolve_texture_path(char* path, size_t path_size, const char* filename)
+{
+    size_t length = 0;
+    const char* curr = filename;
+
+    while(*curr && length < path_size-1) {
+        char c = (*curr == '\\') ? '/' : *curr;
+        int component_start = (length == 0 || path[length-1] == '/');
+        if(component_start && c == '/' && length > 0) {
+            ++curr;
+            continue;
+        }
+        if(component_start && c == '.' && (curr[1] == '/' || curr[1] == '\\')) {
+            curr += 2;
+            continue;
+        }
+        path[length++] = c;
+        ++curr;
+    }
+    path[length] = '\0';
+}
+static CachedTexture* _find_texture(const char* filename, uint64_t hash)
+{
+    int ii;
+    for(ii=0;ii<s_num_textures;++ii) {
+        if(s_textures[ii].hash == hash && strcmp(s_textures[ii].filename, filename) == 0)
+            return s_textures + ii;
+    }
+    return NULL;
+}
 
 /* External functions
  */
@@ -105,3 +152,54 @@ void destroy_texture(Texture T)
 {
     ASSERT_GL(glDeleteTextures(1, &T));
 }
+Texture acquire_texture(const char* filename)
+{
+    char            path[sizeof(s_textures->filename)];
+    uint64_t        hash;
+    CachedTexture*  cached;
+
+    /* Materials without a texture have an empty name */
+    if(filename == NULL || filename[0] == '\0')
+        return 0;
+
+    _resolve_texture_path(path, sizeof(path), filename);
+    hash = hash_data(path, strlen(path), 0);
+    cached = _find_texture(path, hash);
+    if(cached) {
+        ++cached->ref_count;
+        return cached->texture;
+    }
+
+    if(s_num_textures == s_max_textures) {
+        s_max_textures = s_max_textures ? s_max_textures*2 : 32;
+        s_textures = (CachedTexture*)realloc(s_textures, (size_t)s_max_textures*sizeof(CachedTexture));
+    }
+    cached = s_textures + s_num_textures++;
+    strcpy(cached->filename, path);
+    cached->hash = hash;
+    cached->texture = load_texture(path);
+    cached->ref_count = 1;
+    return cached->texture;
+}
+void release_texture(Texture T)
+{
+    int ii;
+    if(T == 0)
+        return;
+    for(ii=0;ii<s_num_textures;++ii) {
+        if(s_textures[ii].texture != T)
+            continue;
+        assert(s_textures[ii].ref_count > 0);
+        if(--s_textures[ii].ref_count == 0) {
+            destroy_texture(T);
+            s_textures[ii] = s_textures[--s_num_textures];
+        }
+        if(s_num_textures == 0) {
+            free(s_textures);
+            s_textures = NULL;
+            s_max_textures = 0;
+        }
+        return;
+    }
+    assert(0 && "Releasing a texture that was not acquired");
+}
@@ -22,4 +22,16 @@ typedef unsigned int Texture;
 Texture load_texture(const char* filename);
 void destroy_texture(Texture T);
 
+/** @brief Returns the texture for `filename`, loading it on first use
+ *  @details Textures are shared by path and reference counted. Every call
+ *      must be balanced by a call to `release_texture`
+ *  @return 0 for an empty or NULL `filename`
+ */
+Texture acquire_texture(const char* filename);
+
+/** @brief Drops a reference taken with `acquire_texture`, destroying the
+ *      texture with the last one. Releasing 0 does nothing
+ */
+void release_texture(Texture T);
+
 #endif /* include guard */
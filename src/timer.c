@@ -138,7 +138,7 @@ double get_delta_time(Timer* timer)
     clock_gettime(CLOCK_MONOTONIC, &time);
     diff = _time_difference(time, timer->prev_time);
     timer->prev_time = time;
-    return diff.tv_sec + diff.tv_nsec*1.0/1000000000;
+    return (double)diff.tv_sec + (double)diff.tv_nsec*1.0/1000000000;
 }
 double get_running_time(Timer* timer)
 {
@@ -146,7 +146,7 @@ double get_running_time(Timer* timer)
     struct timespec diff;
     clock_gettime(CLOCK_MONOTONIC, &time);
     diff = _time_difference(time, timer->start_time);
-    return diff.tv_sec + diff.tv_nsec*1.0/1000000000;
+    return (double)diff.tv_sec + (double)diff.tv_nsec*1.0/1000000000;
 }
 
 #else
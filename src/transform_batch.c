@@ -0,0 +1,106 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "transform_batch.h"
+#include "simd.h"
+
+/* Defines
+ */
+
+/* Types
+ */
+
+/* Constants
+ */
+
+/* Variables
+ */
+
+/* Internal functions
+ */
+
+/* External functions
+ */
+void compute_world_matrices(Mat4* matrices, const Transform* const* transforms, int count)
+{
+    const Simd4 zero = simd4_splat(0.0f);
+    const Simd4 one = simd4_splat(1.0f);
+    const Simd4 two = simd4_splat(2.0f);
+    int ii;
+
+    for(ii=0;ii+4<=count;ii+=4) {
+        /* Each transform is a quaternion followed by a position and scale.
+         * Transpose four of them into x, y, z, w and position, scale lanes
+         */
+        Simd4 qx = simd4_load(&transforms[ii+0]->orientation.x);
+        Simd4 qy = simd4_load(&transforms[ii+1]->orientation.x);
+        Simd4 qz = simd4_load(&transforms[ii+2]->orientation.x);
+        Simd4 qw = simd4_load(&transforms[ii+3]->orientation.x);
+        Simd4 px = simd4_load(&transforms[ii+0]->position.x);
+        Simd4 py = simd4_load(&transforms[ii+1]->position.x);
+        Simd4 pz = simd4_load(&transforms[ii+2]->position.x);
+        Simd4 s = simd4_load(&transforms[ii+3]->position.x);
+        Simd4 xx, yy, zz, xy, zw, xz, yw, yz, xw;
+        Simd4 r0[4], r1[4], r2[4];
+        int jj;
+
+        simd4_transpose(&qx, &qy, &qz, &qw);
+        simd4_transpose(&px, &py, &pz, &s);
+
+        /* Same operations as transform_get_matrix, so the results match */
+        xx = simd4_mul(qx, qx);
+        yy = simd4_mul(qy, qy);
+        zz = simd4_mul(qz, qz);
+        xy = simd4_mul(qx, qy);
+        zw = simd4_mul(qz, qw);
+        xz = simd4_mul(qx, qz);
+        yw = simd4_mul(qy, qw);
+        yz = simd4_mul(qy, qz);
+        xw = simd4_mul(qx, qw);
+
+        r0[0] = simd4_mul(simd4_sub(one, simd4_mul(two, simd4_add(yy, zz))), s);
+        r0[1] = simd4_mul(simd4_mul(two, simd4_add(xy, zw)), s);
+        r0[2] = simd4_mul(simd4_mul(two, simd4_sub(xz, yw)), s);
+        r0[3] = zero;
+        r1[0] = simd4_mul(simd4_mul(two, simd4_sub(xy, zw)), s);
+        r1[1] = simd4_mul(simd4_sub(one, simd4_mul(two, simd4_add(xx, zz))), s);
+        r1[2] = simd4_mul(simd4_mul(two, simd4_add(yz, xw)), s);
+        r1[3] = zero;
+        r2[0] = simd4_mul(simd4_mul(two, simd4_add(xz, yw)), s);
+        r2[1] = simd4_mul(simd4_mul(two, simd4_sub(yz, xw)), s);
+        r2[2] = simd4_mul(simd4_sub(one, simd4_mul(two, simd4_add(xx, yy))), s);
+        r2[3] = zero;
+
+        /* Back to one row per matrix */
+        simd4_transpose(&r0[0], &r0[1], &r0[2], &r0[3]);
+        simd4_transpose(&r1[0], &r1[1], &r1[2], &r1[3]);
+        simd4_transpose(&r2[0], &r2[1], &r2[2], &r2[3]);
+        s = one;
+        simd4_transpose(&px, &py, &pz, &s);
+        for(jj=0;jj<4;++jj) {
+            Mat4* matrix = &matrices[ii+jj];
+            simd4_store(&matrix->r0.x, r0[jj]);
+            simd4_store(&matrix->r1.x, r1[jj]);
+            simd4_store(&matrix->r2.x, r2[jj]);
+        }
+        simd4_store(&matrices[ii+0].r3.x, px);
+        simd4_store(&matrices[ii+1].r3.x, py);
+        simd4_store(&matrices[ii+2].r3.x, pz);
+        simd4_store(&matrices[ii+3].r3.x, s);
+    }
+    for(;ii<count;++ii)
+        matrices[ii] = transform_get_matrix(*transforms[ii]);
+}
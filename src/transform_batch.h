@@ -0,0 +1,30 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __transform_batch_h__
+#define __transform_batch_h__
+
+#include "vec_math.h"
+
+/** @brief Computes `transform_get_matrix(*transforms[ii])` for every `ii` in
+ *      [0, count), four transforms at a time in structure-of-arrays form
+ *  @param matrices [out] `count` matrices
+ *  @param transforms [in] `count` transforms, gathered through pointers so
+ *         they can stay inside their models
+ */
+void compute_world_matrices(Mat4* matrices, const Transform* const* transforms, int count);
+
+#endif /* include guard */
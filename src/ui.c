@@ -95,6 +95,12 @@ typedef struct {
 } bmfont_kerning_pairs_t;
 #pragma pack(pop)
 
+typedef struct GlyphVertex
+{
+    Vec3    pos;
+    Vec2    tex;
+} GlyphVertex;
+
 typedef struct FontData
 {
     bmfont_info_t   info;
@@ -107,8 +113,9 @@ typedef struct FontData
 typedef struct Font {
     FontData    data;
     GLuint      textures[16];
-    GLuint      char_vertices[256];
-    GLuint      char_indices;
+    GLuint      char_vertices;  /* Four vertices per character */
+    GLuint      char_indices;   /* Six indices per character */
+    GLuint      vertex_array;
 } Font;
 
 struct UI
@@ -232,17 +239,14 @@ static void _draw_string(UI* U, float x, float y, float scale, char* string)
         bmfont_char_t glyph = U->font.data.chars[c];
 
         if(c != ' ') {
-            float* ptr = 0;
+            uint16_t* ptr = 0;
             Mat4 world = mat4_scalef(scale,scale,1.0f);
             world.r3.x = x;
             world.r3.y = y;
 
             ASSERT_GL(glUniformMatrix4fv(U->u_World, 1, GL_FALSE, (float*)&world));
             ASSERT_GL(glBindTexture(GL_TEXTURE_2D, U->font.textures[glyph.page]));
-            ASSERT_GL(glBindBuffer(GL_ARRAY_BUFFER, U->font.char_vertices[c]));
-            ASSERT_GL(glVertexAttribPointer(kPositionSlot,    3, GL_FLOAT, GL_FALSE, sizeof(float)*5, (void*)(ptr+=0)));
-            ASSERT_GL(glVertexAttribPointer(kTexCoordSlot,    2, GL_FLOAT, GL_FALSE, sizeof(float)*5, (void*)(ptr+=3)));
-            ASSERT_GL(glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, NULL));
+            ASSERT_GL(glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, (void*)(ptr+(uint8_t)c*6)));
         }
         x += (glyph.xadvance/(float)U->font.data.common.lineHeight)*scale;
         ++string;
@@ -260,6 +264,9 @@ UI* create_ui(Graphics* G)
     };
     int ii = 0;
     UI* U = (UI*)calloc(1, sizeof(UI));
+    GlyphVertex* char_vertices = (GlyphVertex*)calloc(256*4, sizeof(GlyphVertex));
+    uint16_t* char_indices = (uint16_t*)malloc(256*sizeof(kQuadIndices));
+    float* ptr = 0;
 
     U->G = G;
     U->font.data = _load_font("inconsolata.fnt");
@@ -268,26 +275,17 @@ UI* create_ui(Graphics* G)
     for(ii=0;ii<16;++ii) {
         if(U->font.data.pages[ii].pageName[0] == '\0')
             break;
-        U->font.textures[ii] = load_texture(U->font.data.pages[ii].pageName);
+        U->font.textures[ii] = acquire_texture(U->font.data.pages[ii].pageName);
     }
 
-    /* Create character index buffer */
-    ASSERT_GL(glGenBuffers(1, &U->font.char_indices));
-    ASSERT_GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, U->font.char_indices));
-    ASSERT_GL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(kQuadIndices), kQuadIndices, GL_STATIC_DRAW));
-    ASSERT_GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
-
-    /* Create character meshes */
+    /* Create character meshes, all in one buffer */
     for(ii=0;ii<256;++ii) {
         Vec3 pos_transform;
         Vec3 pos_scale;
         Vec2 tex_scale;
         int jj;
         bmfont_char_t c = U->font.data.chars[ii];
-        struct {
-            Vec3    pos;
-            Vec2    tex;
-        } quad_vertices[] =
+        GlyphVertex quad_vertices[] =
         {
             0.0f,    c.height, 0.0f,     c.x,         c.y,          // TL
             c.width, c.height, 0.0f,     c.x+c.width, c.y,          // TR
@@ -308,11 +306,31 @@ UI* create_ui(Graphics* G)
             quad_vertices[jj].pos = vec3_div(quad_vertices[jj].pos, pos_scale);
             quad_vertices[jj].tex = vec2_div(quad_vertices[jj].tex, tex_scale);
         }
-        ASSERT_GL(glGenBuffers(1, &U->font.char_vertices[ii]));
-        ASSERT_GL(glBindBuffer(GL_ARRAY_BUFFER, U->font.char_vertices[ii]));
-        ASSERT_GL(glBufferData(GL_ARRAY_BUFFER, sizeof(quad_vertices), quad_vertices, GL_STATIC_DRAW));
-        ASSERT_GL(glBindBuffer(GL_ARRAY_BUFFER, 0));
+        memcpy(char_vertices + ii*4, quad_vertices, sizeof(quad_vertices));
     }
+    for(ii=0;ii<256;++ii) {
+        int jj;
+        for(jj=0; jj<6; ++jj)
+            char_indices[ii*6+jj] = (uint16_t)(ii*4 + kQuadIndices[jj]);
+    }
+
+    /* Create vertex array */
+    ASSERT_GL(glGenVertexArrays(1, &U->font.vertex_array));
+    ASSERT_GL(glBindVertexArray(U->font.vertex_array));
+    ASSERT_GL(glGenBuffers(1, &U->font.char_vertices));
+    ASSERT_GL(glBindBuffer(GL_ARRAY_BUFFER, U->font.char_vertices));
+    ASSERT_GL(glBufferData(GL_ARRAY_BUFFER, 256*4*sizeof(GlyphVertex), char_vertices, GL_STATIC_DRAW));
+    ASSERT_GL(glEnableVertexAttribArray(kPositionSlot));
+    ASSERT_GL(glEnableVertexAttribArray(kTexCoordSlot));
+    ASSERT_GL(glVertexAttribPointer(kPositionSlot,    3, GL_FLOAT, GL_FALSE, sizeof(GlyphVertex), (void*)(ptr+=0)));
+    ASSERT_GL(glVertexAttribPointer(kTexCoordSlot,    2, GL_FLOAT, GL_FALSE, sizeof(GlyphVertex), (void*)(ptr+=3)));
+    ASSERT_GL(glBindBuffer(GL_ARRAY_BUFFER, 0));
+    ASSERT_GL(glGenBuffers(1, &U->font.char_indices));
+    ASSERT_GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, U->font.char_indices));
+    ASSERT_GL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, 256*sizeof(kQuadIndices), char_indices, GL_STATIC_DRAW));
+    ASSERT_GL(glBindVertexArray(0));
+    free(char_vertices);
+    free(char_indices);
 
     /* Create shader */
     U->program = create_program("shaders/ui/vertex.glsl",
@@ -328,6 +346,9 @@ UI* create_ui(Graphics* G)
 }
 void destroy_ui(UI* U)
 {
+    int ii;
+    for(ii=0;ii<16;++ii)
+        release_texture(U->font.textures[ii]);
     free(U);
 }
 
@@ -340,7 +361,7 @@ void resize_ui(UI* U, int width, int height)
 void add_string(UI* U, float x, float y, float scale, const char* string)
 {
     int index = U->num_strings++;
-    assert(index <= MAX_STRINGS);
+    assert(index < MAX_STRINGS);
     U->strings[index].x = x;
     U->strings[index].y = y;
     U->strings[index].scale = scale;
@@ -355,7 +376,7 @@ void draw_ui(UI* U)
     ASSERT_GL(glBlendFunc(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA));
     ASSERT_GL(glUseProgram(U->program));
     ASSERT_GL(glUniformMatrix4fv(U->u_ViewProjection, 1, GL_FALSE, (float*)&U->proj_matrix));
-    ASSERT_GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, U->font.char_indices));
+    ASSERT_GL(glBindVertexArray(U->font.vertex_array));
     ASSERT_GL(glActiveTexture(GL_TEXTURE0));
     for (ii=0; ii<U->num_strings; ++ii) {
         _draw_string(U, U->strings[ii].x, U->strings[ii].y, U->strings[ii].scale, U->strings[ii].string);
@@ -104,6 +104,89 @@ void split_filename(char* path, size_t path_size,
         strncpy(path, filename, path_size);
         path[curr-filename] = '\0';
     }
-    strncpy(file, curr, end-curr);
+    strncpy(file, curr, (size_t)(end-curr));
 }
+uint64_t hash_data(const void* data, size_t size, uint64_t seed)
+{
+    const uint64_t m = 0xc6a4a7935bd1e995ULL;
+    const int r = 47;
+    const uint8_t* bytes = (const uint8_t*)data;
+    const uint8_t* end = bytes + (size & ~(size_t)7);
+    uint64_t h = seed ^ (size * m);
+
+    while(bytes != end) {
+        uint64_t k;
+        memcpy(&k, bytes, sizeof(k));
+        bytes += sizeof(k);
+
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+
+        h ^= k;
+        h *= m;
+    }
+    if(size & 7) {
+        /* Same as MurmurHash64A's tail on little-endian CPUs */
+        uint64_t k = 0;
+        memcpy(&k, bytes, size & 7);
+        h ^= k;
+        h *= m;
+    }
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+void radix_sort(uint64_t* keys, uint32_t* values,
+                uint64_t* temp_keys, uint32_t* temp_values, size_t count)
+{
+    size_t histograms[8][256];
+    uint64_t* src_keys = keys;
+    uint32_t* src_values = values;
+    uint64_t* dst_keys = temp_keys;
+    uint32_t* dst_values = temp_values;
+    size_t ii;
+    int byte;
+
+    /* Count every byte in one pass over the keys */
+    memset(histograms, 0, sizeof(histograms));
+    for(ii=0;ii<count;++ii) {
+        uint64_t key = keys[ii];
+        for(byte=0;byte<8;++byte)
+            histograms[byte][(key >> (byte*8)) & 0xFF]++;
+    }
+
+    for(byte=0;byte<8;++byte) {
+        size_t* histogram = histograms[byte];
+        size_t offset = 0;
+        int shift = byte*8;
+        int jj;
+
+        if(count == 0 || histogram[(keys[0] >> shift) & 0xFF] == count)
+            continue; /* Every key has the same byte */
 
+        for(jj=0;jj<256;++jj) {
+            size_t bin_count = histogram[jj];
+            histogram[jj] = offset;
+            offset += bin_count;
+        }
+        for(ii=0;ii<count;++ii) {
+            size_t index = histogram[(src_keys[ii] >> shift) & 0xFF]++;
+            dst_keys[index] = src_keys[ii];
+            dst_values[index] = src_values[ii];
+        }
+        {
+            uint64_t* swap_keys = src_keys;
+            uint32_t* swap_values = src_values;
+            src_keys = dst_keys;
+            src_values = dst_values;
+            dst_keys = swap_keys;
+            dst_values = swap_values;
+        }
+    }
+    if(src_keys != keys) {
+        memcpy(keys, src_keys, count*sizeof(*keys));
+        memcpy(values, src_values, count*sizeof(*values));
+    }
+}
@@ -18,6 +18,7 @@
 #define __utility_h__
 
 #include <stddef.h>
+#include <stdint.h>
 
 /** @brief Retrieves a line from a string
  *  @param line [in] A buffer to hold the retrieved line
@@ -33,4 +34,18 @@ void split_filename(char* path, size_t path_size,
                     char* file, size_t file_size,
                     const char* filename);
 
+/** @brief Hashes a block of memory (64-bit MurmurHash2). Not cryptographic
+ *  @param seed [in] Starting value, e.g. the hash of a previous block
+ */
+uint64_t hash_data(const void* data, size_t size, uint64_t seed);
+
+/** @brief Sorts 64-bit keys, and the values that go with them, into
+ *      ascending order with a radix sort. Equal keys keep their order, and
+ *      bytes that are the same in every key are skipped
+ *  @param temp_keys [in] Scratch space for `count` keys
+ *  @param temp_values [in] Scratch space for `count` values
+ */
+void radix_sort(uint64_t* keys, uint32_t* values,
+                uint64_t* temp_keys, uint32_t* temp_values, size_t count);
+
 #endif /* include guard */
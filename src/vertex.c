@@ -0,0 +1,312 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "vertex.h"
+
+/* Defines
+ */
+
+/* Types
+ */
+
+/* Constants
+ */
+/* Smallest |w| a packed quaternion may have, so the sign of w survives
+ * quantization (a short has no -0) */
+static const float kQTangentBias = 1.0f/32767.0f;
+static const float kSnorm10Max = 511.0f;
+static const float kUnorm16Max = 65535.0f;
+
+/* Variables
+ */
+
+/* Internal functions
+ */
+/** Quaternion of the rotation whose rows (see quat_to_mat3) are x, y and z
+ */
+static Quaternion _quat_from_axes(Vec3 x, Vec3 y, Vec3 z)
+{
+    Quaternion q;
+    float trace = x.x + y.y + z.z;
+    float s;
+    if(trace > 0.0f) {
+        s = 0.5f/sqrtf(trace + 1.0f);
+        q.w = 0.25f/s;
+        q.x = (y.z - z.y)*s;
+        q.y = (z.x - x.z)*s;
+        q.z = (x.y - y.x)*s;
+    } else if(x.x > y.y && x.x > z.z) {
+        s = 0.5f/sqrtf(1.0f + x.x - y.y - z.z);
+        q.x = 0.25f/s;
+        q.y = (x.y + y.x)*s;
+        q.z = (x.z + z.x)*s;
+        q.w = (y.z - z.y)*s;
+    } else if(y.y > z.z) {
+        s = 0.5f/sqrtf(1.0f + y.y - x.x - z.z);
+        q.y = 0.25f/s;
+        q.x = (x.y + y.x)*s;
+        q.z = (y.z + z.y)*s;
+        q.w = (z.x - x.z)*s;
+    } else {
+        s = 0.5f/sqrtf(1.0f + z.z - x.x - y.y);
+        q.z = 0.25f/s;
+        q.x = (x.z + z.x)*s;
+        q.y = (y.z + z.y)*s;
+        q.w = (x.y - y.x)*s;
+    }
+    return quat_normalize(q);
+}
+static int16_t _pack_snorm16(float f)
+{
+    f = f < -1.0f ? -1.0f : (f > 1.0f ? 1.0f : f);
+    return (int16_t)(f >= 0.0f ? f*32767.0f + 0.5f : f*32767.0f - 0.5f);
+}
+static float _unpack_snorm16(int16_t s)
+{
+    float f = s/32767.0f;
+    return f < -1.0f ? -1.0f : f;
+}
+
+static uint16_t _float_to_half(float f)
+{
+    union { float f; uint32_t u; } bits;
+    uint32_t sign, mantissa, remainder, half;
+    int exponent;
+    bits.f = f;
+    sign = (bits.u >> 16) & 0x8000;
+    exponent = (int)((bits.u >> 23) & 0xFF) - 127 + 15;
+    mantissa = bits.u & 0x7FFFFF;
+    if(exponent == 0xFF - 127 + 15)
+        return (uint16_t)(sign | 0x7C00 | (mantissa ? 0x200 : 0)); /* Inf, NaN */
+    if(exponent >= 31)
+        return (uint16_t)(sign | 0x7C00);
+    if(exponent <= 0) {
+        /* Denormal, rounded to nearest even */
+        uint32_t shift = (uint32_t)(14 - exponent);
+        if(exponent < -10)
+            return (uint16_t)sign;
+        mantissa |= 0x800000;
+        half = mantissa >> shift;
+        remainder = mantissa & ((1u << shift) - 1);
+        if(remainder > (1u << (shift-1)) || (remainder == (1u << (shift-1)) && (half & 1)))
+            ++half;
+        return (uint16_t)(sign | half);
+    }
+    /* Rounding may carry into the exponent, up to infinity */
+    half = ((uint32_t)exponent << 10) | (mantissa >> 13);
+    remainder = mantissa & 0x1FFF;
+    if(remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+        ++half;
+    return (uint16_t)(sign | half);
+}
+static float _half_to_float(uint16_t h)
+{
+    union { float f; uint32_t u; } bits;
+    uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+    uint32_t exponent = (h >> 10) & 0x1F;
+    uint32_t mantissa = h & 0x3FF;
+    if(exponent == 0x1F) {
+        bits.u = sign | 0x7F800000 | (mantissa << 13);
+    } else if(exponent != 0) {
+        bits.u = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    } else {
+        /* Denormal */
+        bits.f = (float)mantissa/16777216.0f;
+        bits.u |= sign;
+    }
+    return bits.f;
+}
+static Vec3 _octahedral_decode(float x, float y)
+{
+    Vec3 v = vec3_create(x, y, 1.0f - fabsf(x) - fabsf(y));
+    if(v.z < 0.0f) {
+        v.x = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        v.y = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+    }
+    return vec3_normalize(v);
+}
+static int _snorm10_unpack(uint32_t bits)
+{
+    int value = (int)(bits & 0x3FF);
+    return value >= 0x200 ? value - 0x400 : value;
+}
+/** Packs `v` as an octahedral x, y pair into a 10:10:10:2 signed normalized
+ *  word, with `w` (-1, 0 or 1) in the top two bits. Of the four quantized
+ *  points around the exact encoding, the one decoding closest to `v` wins
+ */
+static uint32_t _pack_octahedral(Vec3 v, int w)
+{
+    float l1 = fabsf(v.x) + fabsf(v.y) + fabsf(v.z);
+    float x, y;
+    int qx, qy, best_x = 0, best_y = 0;
+    float best = -2.0f;
+    if(l1 == 0.0f)
+        v = vec3_create(0.0f, 0.0f, 1.0f), l1 = 1.0f;
+    x = v.x/l1;
+    y = v.y/l1;
+    if(v.z < 0.0f) {
+        float fold_x = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float fold_y = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = fold_x;
+        y = fold_y;
+    }
+    v = vec3_normalize(v);
+    for(qx = (int)floorf(x*kSnorm10Max); qx <= (int)ceilf(x*kSnorm10Max); ++qx) {
+        for(qy = (int)floorf(y*kSnorm10Max); qy <= (int)ceilf(y*kSnorm10Max); ++qy) {
+            float d = vec3_dot(v, _octahedral_decode((float)qx/kSnorm10Max, (float)qy/kSnorm10Max));
+            if(d > best) {
+                best = d;
+                best_x = qx;
+                best_y = qy;
+            }
+        }
+    }
+    return ((uint32_t)best_x & 0x3FF) | (((uint32_t)best_y & 0x3FF) << 10) | (((uint32_t)w & 0x3) << 30);
+}
+static Vec3 _unpack_octahedral(uint32_t bits)
+{
+    return _octahedral_decode((float)_snorm10_unpack(bits)/kSnorm10Max,
+                              (float)_snorm10_unpack(bits >> 10)/kSnorm10Max);
+}
+
+/* External functions
+ */
+size_t get_vertex_size(VertexFormat format)
+{
+    switch(format) {
+    case kVertexFormatFloat:        return sizeof(Vertex);
+    case kVertexFormatQTangent:     return sizeof(QTangentVertex);
+    case kVertexFormatCompressed:   return sizeof(CompressedVertex);
+    default:                        return 0;
+    }
+}
+void pack_qtangent_vertices(QTangentVertex* dest, const Vertex* src, size_t count)
+{
+    size_t ii;
+    for(ii=0;ii<count;++ii) {
+        Vec3 n = src[ii].normal;
+        Vec3 t = src[ii].tangent;
+        Vec3 b;
+        Quaternion q;
+        float reflection;
+
+        /* Orthonormal, right-handed frame; the reflection goes into w */
+        n = vec3_length_sq(n) > 0.0f ? vec3_normalize(n) : vec3_create(0.0f, 0.0f, 1.0f);
+        t = vec3_sub(t, vec3_mul_scalar(n, vec3_dot(n, t)));
+        if(vec3_length_sq(t) < 1e-12f)
+            t = vec3_cross(fabsf(n.x) < 0.9f ? vec3_create(0.0f, 1.0f, 0.0f) : vec3_create(0.0f, 0.0f, 1.0f), n);
+        t = vec3_normalize(t);
+        b = vec3_cross(n, t);
+        reflection = vec3_dot(b, src[ii].bitangent) < 0.0f ? -1.0f : 1.0f;
+
+        q = _quat_from_axes(t, b, n);
+        if(q.w < 0.0f)
+            q = vec4_mul_scalar(q, -1.0f);
+        if(q.w < kQTangentBias) {
+            float xyz = sqrtf(q.x*q.x + q.y*q.y + q.z*q.z);
+            float scale = xyz > 0.0f ? sqrtf(1.0f - kQTangentBias*kQTangentBias)/xyz : 0.0f;
+            q = vec4_create(q.x*scale, q.y*scale, q.z*scale, kQTangentBias);
+        }
+        q = vec4_mul_scalar(q, reflection);
+
+        dest[ii].position = src[ii].position;
+        dest[ii].qtangent[0] = _pack_snorm16(q.x);
+        dest[ii].qtangent[1] = _pack_snorm16(q.y);
+        dest[ii].qtangent[2] = _pack_snorm16(q.z);
+        dest[ii].qtangent[3] = _pack_snorm16(q.w);
+        dest[ii].texcoord = src[ii].texcoord;
+    }
+}
+void unpack_qtangent_vertices(Vertex* dest, const QTangentVertex* src, size_t count)
+{
+    size_t ii;
+    for(ii=0;ii<count;++ii) {
+        Quaternion q = vec4_create(_unpack_snorm16(src[ii].qtangent[0]),
+                                   _unpack_snorm16(src[ii].qtangent[1]),
+                                   _unpack_snorm16(src[ii].qtangent[2]),
+                                   _unpack_snorm16(src[ii].qtangent[3]));
+        float reflection = q.w < 0.0f ? -1.0f : 1.0f;
+        q = quat_normalize(q);
+
+        dest[ii].position = src[ii].position;
+        dest[ii].normal = quat_get_z_axis(q);
+        dest[ii].tangent = quat_get_x_axis(q);
+        dest[ii].bitangent = vec3_mul_scalar(quat_get_y_axis(q), reflection);
+        dest[ii].texcoord = src[ii].texcoord;
+    }
+}
+PositionQuantization get_position_quantization(const Vertex* vertices, size_t count)
+{
+    PositionQuantization quantization;
+    Vec3 min = vec3_create(0.0f, 0.0f, 0.0f);
+    Vec3 max = min;
+    size_t ii;
+    if(count)
+        min = max = vertices[0].position;
+    for(ii=1;ii<count;++ii) {
+        min = vec3_min(min, vertices[ii].position);
+        max = vec3_max(max, vertices[ii].position);
+    }
+    quantization.scale = vec3_sub(max, min);
+    quantization.bias = min;
+    return quantization;
+}
+void compress_vertices(CompressedVertex* dest, const Vertex* src, size_t count,
+                       const PositionQuantization* quantization)
+{
+    const float* scale = &quantization->scale.x;
+    const float* bias = &quantization->bias.x;
+    size_t ii;
+    int jj;
+    for(ii=0;ii<count;++ii) {
+        const float* position = &src[ii].position.x;
+        Vec3 n = src[ii].normal;
+        Vec3 t = src[ii].tangent;
+        int sign = vec3_dot(vec3_cross(n, t), src[ii].bitangent) < 0.0f ? -1 : 1;
+        for(jj=0;jj<3;++jj) {
+            float f = scale[jj] > 0.0f ? (position[jj] - bias[jj])/scale[jj] : 0.0f;
+            f = f < 0.0f ? 0.0f : (f > 1.0f ? 1.0f : f);
+            dest[ii].position[jj] = (uint16_t)(f*kUnorm16Max + 0.5f);
+        }
+        dest[ii].position[3] = 0;
+        dest[ii].normal = _pack_octahedral(n, 0);
+        dest[ii].tangent = _pack_octahedral(t, sign);
+        dest[ii].texcoord[0] = _float_to_half(src[ii].texcoord.x);
+        dest[ii].texcoord[1] = _float_to_half(src[ii].texcoord.y);
+    }
+}
+void decompress_vertices(Vertex* dest, const CompressedVertex* src, size_t count,
+                         const PositionQuantization* quantization)
+{
+    const float* scale = &quantization->scale.x;
+    const float* bias = &quantization->bias.x;
+    size_t ii;
+    int jj;
+    for(ii=0;ii<count;++ii) {
+        float* position = &dest[ii].position.x;
+        for(jj=0;jj<3;++jj)
+            position[jj] = src[ii].position[jj]/kUnorm16Max*scale[jj] + bias[jj];
+        dest[ii].normal = _unpack_octahedral(src[ii].normal);
+        dest[ii].tangent = _unpack_octahedral(src[ii].tangent);
+        dest[ii].bitangent = vec3_cross(dest[ii].normal, dest[ii].tangent);
+        if(vec3_length_sq(dest[ii].bitangent) > 0.0f)
+            dest[ii].bitangent = vec3_normalize(dest[ii].bitangent);
+        if(src[ii].tangent >> 31) /* Negative w */
+            dest[ii].bitangent = vec3_mul_scalar(dest[ii].bitangent, -1.0f);
+        dest[ii].texcoord.x = _half_to_float(src[ii].texcoord[0]);
+        dest[ii].texcoord.y = _half_to_float(src[ii].texcoord[1]);
+    }
+}
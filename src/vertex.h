@@ -17,6 +17,8 @@
 #ifndef __vertex_h__
 #define __vertex_h__
 
+#include <stddef.h>
+#include <stdint.h>
 #include "vec_math.h"
 
 typedef struct Vertex
@@ -28,6 +30,50 @@ typedef struct Vertex
     Vec2    texcoord;
 } Vertex;
 
+/** Vertex with the tangent frame packed into one unit quaternion, stored as
+ *  normalized shorts. The quaternion rotates +x, +y, +z onto the tangent,
+ *  bitangent and normal, and its w is negative when the bitangent has to be
+ *  flipped (mirrored UVs). 28 bytes instead of 56
+ */
+typedef struct QTangentVertex
+{
+    Vec3    position;
+    int16_t qtangent[4];
+    Vec2    texcoord;
+} QTangentVertex;
+
+/** Quantized vertex, 20 bytes. Positions are 16 bit unsigned normalized
+ *  within the mesh bounds (see PositionQuantization). The normal and tangent
+ *  are octahedral encoded into the x and y of signed normalized 10:10:10:2
+ *  words, and the tangent's w holds the bitangent sign. Texture coordinates
+ *  are half floats
+ */
+typedef struct CompressedVertex
+{
+    uint16_t    position[4];    /* w unused */
+    uint32_t    normal;
+    uint32_t    tangent;
+    uint16_t    texcoord[2];
+} CompressedVertex;
+
+/** Dequantization constants of compressed positions, applied to the
+ *  normalized [0,1] values: position = normalized*scale + bias
+ */
+typedef struct PositionQuantization
+{
+    Vec3    scale;
+    Vec3    bias;
+} PositionQuantization;
+
+typedef enum VertexFormat
+{
+    kVertexFormatFloat = 0, /* Vertex */
+    kVertexFormatQTangent,  /* QTangentVertex */
+    kVertexFormatCompressed,/* CompressedVertex */
+
+    kNumVertexFormats
+} VertexFormat;
+
 typedef enum AttributeSlot
 {
     kPositionSlot   = 0,
@@ -35,9 +81,31 @@ typedef enum AttributeSlot
     kTangentSlot,
     kBitangentSlot,
     kTexCoordSlot,
+    kQTangentSlot,
+    kPositionScaleSlot,     /* Constant, not an array */
+    kPositionBiasSlot,      /* Constant, not an array */
 
     kEmptySlot = -1
 } AttributeSlot;
 
+/** @return sizeof the vertex struct used by `format`
+ */
+size_t get_vertex_size(VertexFormat format);
+
+/** @brief Converts `count` vertices between formats. Packing re-orthonormalizes
+ *      each tangent frame against its normal
+ */
+void pack_qtangent_vertices(QTangentVertex* dest, const Vertex* src, size_t count);
+void unpack_qtangent_vertices(Vertex* dest, const QTangentVertex* src, size_t count);
+
+/** @return Constants that spread the bounds of `vertices` over the full
+ *      quantized range
+ */
+PositionQuantization get_position_quantization(const Vertex* vertices, size_t count);
+void compress_vertices(CompressedVertex* dest, const Vertex* src, size_t count,
+                       const PositionQuantization* quantization);
+void decompress_vertices(Vertex* dest, const CompressedVertex* src, size_t count,
+                         const PositionQuantization* quantization);
+
 
 #endif /* include guard */
@@ -0,0 +1,291 @@
+extern "C" {
+#include "../src/utility.h"
+#include "../src/scene.h"
+#include "../src/scene_data.h"
+#include "../src/timer.h"
+#include "../src/transform_batch.h"
+}
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+/* Constants
+ */
+static const char kUsage[] =
+    "usage: benchmark [options] [file.obj ...]\n"
+    "  Loads each OBJ with _load_scene_data and reports its throughput. With no\n"
+    "  files, a synthetic OBJ/MTL pair is generated and loaded instead.\n"
+    "\n"
+    "  --triangles N    Triangles in the generated OBJ (default 1000000)\n"
+    "  --groups N       usemtl groups in the generated OBJ (default 16)\n"
+    "  --quads          Generate quad faces instead of triangles\n"
+    "  --untextured     Generate faces without texture coordinates\n"
+    "  --dir PATH       Where to write the generated files (default /tmp)\n"
+    "  --runs N         Loads per file (default 3)\n"
+    "  --threads N      Loader threads, 0 for one per CPU (default 0)\n"
+    "  --stream BYTES   Stream files with this memory limit\n"
+    "  --matrices N     Instead of loading, time world matrices for N models,\n"
+    "                   computed per draw or in one batch per frame\n";
+
+/* Types
+ */
+struct GeneratorOptions
+{
+    unsigned long   triangles;
+    unsigned long   groups;
+    int             quads;
+    int             textured;
+};
+
+/* Variables
+ */
+
+/* Internal functions
+ */
+/** Writes a grid of `options.triangles` triangles, split into contiguous
+ *  `usemtl` groups, plus an MTL file with a material per group.
+ */
+static int _generate_obj(const std::string& directory, const GeneratorOptions& options, std::string* obj_filename)
+{
+    char name[128];
+    sprintf(name, "synthetic_%lu_%lu%s%s", options.triangles, options.groups,
+            options.quads ? "_quads" : "", options.textured ? "" : "_untextured");
+    std::string obj_path = directory + "/" + name + ".obj";
+    std::string mtl_name = std::string(name) + ".mtl";
+    std::string mtl_path = directory + "/" + mtl_name;
+
+    FILE* mtl = fopen(mtl_path.c_str(), "w");
+    if(mtl == NULL)
+        return -1;
+    for(unsigned long ii=0; ii<options.groups; ++ii) {
+        fprintf(mtl, "newmtl material%lu\n", ii);
+        fprintf(mtl, "Ns 32.000000\nKs 0.500000 0.500000 0.500000\n");
+        fprintf(mtl, "map_Kd diffuse%lu.png\nmap_bump normal%lu.png\n\n", ii, ii);
+    }
+    fclose(mtl);
+
+    FILE* obj = fopen(obj_path.c_str(), "w");
+    if(obj == NULL)
+        return -1;
+
+    /* A square grid of cells with two triangles each */
+    unsigned long cells = (options.triangles + 1)/2;
+    unsigned long width = 1;
+    while(width*width < cells)
+        ++width;
+    unsigned long height = (cells + width - 1)/width;
+
+    fprintf(obj, "# %lu triangles, %lu groups\nmtllib %s\n", options.triangles, options.groups, mtl_name.c_str());
+    for(unsigned long y=0; y<=height; ++y) {
+        for(unsigned long x=0; x<=width; ++x) {
+            float fx = (float)x/(float)width;
+            float fy = (float)y/(float)height;
+            fprintf(obj, "v %f %f %f\n", fx*100.0f - 50.0f, 0.25f*(float)((x ^ y) & 7), fy*100.0f - 50.0f);
+            if(options.textured)
+                fprintf(obj, "vt %f %f\n", fx, fy);
+            fprintf(obj, "vn %f %f %f\n", 0.0f, 1.0f, 0.0f);
+        }
+    }
+
+    unsigned long group = 0;
+    unsigned long group_size = (cells + options.groups - 1)/options.groups;
+    for(unsigned long cell=0; cell<cells; ++cell) {
+        if(cell % group_size == 0) {
+            fprintf(obj, "g group%lu\nusemtl material%lu\n", group, group);
+            ++group;
+        }
+        unsigned long x = cell % width;
+        unsigned long y = cell / width;
+        unsigned long c[4];
+        c[0] = y*(width+1) + x + 1;
+        c[1] = c[0] + 1;
+        c[2] = c[1] + width + 1;
+        c[3] = c[0] + width + 1;
+        if(options.textured) {
+            if(options.quads) {
+                fprintf(obj, "f %lu/%lu/%lu %lu/%lu/%lu %lu/%lu/%lu %lu/%lu/%lu\n",
+                        c[0], c[0], c[0], c[1], c[1], c[1], c[2], c[2], c[2], c[3], c[3], c[3]);
+            } else {
+                fprintf(obj, "f %lu/%lu/%lu %lu/%lu/%lu %lu/%lu/%lu\n", c[0], c[0], c[0], c[1], c[1], c[1], c[2], c[2], c[2]);
+                fprintf(obj, "f %lu/%lu/%lu %lu/%lu/%lu %lu/%lu/%lu\n", c[0], c[0], c[0], c[2], c[2], c[2], c[3], c[3], c[3]);
+            }
+        } else {
+            if(options.quads) {
+                fprintf(obj, "f %lu//%lu %lu//%lu %lu//%lu %lu//%lu\n", c[0], c[0], c[1], c[1], c[2], c[2], c[3], c[3]);
+            } else {
+                fprintf(obj, "f %lu//%lu %lu//%lu %lu//%lu\n", c[0], c[0], c[1], c[1], c[2], c[2]);
+                fprintf(obj, "f %lu//%lu %lu//%lu %lu//%lu\n", c[0], c[0], c[2], c[2], c[3], c[3]);
+            }
+        }
+    }
+    fclose(obj);
+
+    *obj_filename = obj_path;
+    return 0;
+}
+static void _benchmark_file(const char* filename, int runs)
+{
+    printf("%s\n", filename);
+    printf("  run   total ms   parse MB/s   vertices/s   weld ms   tangent ms   peak MB\n");
+    for(int ii=0; ii<runs; ++ii) {
+        SceneLoadStats stats;
+        SceneData* scene = _load_scene_data(filename);
+        if(scene == NULL) {
+            printf("  Unable to load %s\n", filename);
+            return;
+        }
+        get_scene_load_stats(&stats);
+        _free_scene_data(scene);
+
+        printf("  %3d  %9.1f  %11.1f  %11.0f  %8.1f  %11.1f  %8.1f\n", ii,
+               stats.total_time*1000.0,
+               (double)stats.file_size/1e6/stats.parse_time,
+               (double)stats.num_vertices/stats.total_time,
+               stats.weld_time*1000.0,
+               stats.tangent_time*1000.0,
+               (double)stats.peak_memory/1e6);
+    }
+    printf("\n");
+}
+
+/** Times the world matrices of a frame drawn in two passes, like the light
+ *  pre-pass renderer: once computed by every draw, and once batched up front
+ *  and read by both passes. Each draw copies its matrix out, as uploading
+ *  the uniform would
+ */
+static void _benchmark_matrices(int count, int runs)
+{
+    const int kPasses = 2;
+    std::vector<Model> models((size_t)count);
+    std::vector<const Transform*> transforms((size_t)count);
+    std::vector<Mat4> matrices((size_t)count);
+    std::vector<Mat4> uploads((size_t)count);
+    Timer* timer = create_timer();
+    float max_error = 0.0f;
+
+    srand(1);
+    for(int ii=0; ii<count; ++ii) {
+        Transform& transform = models[(size_t)ii].transform;
+        transform.orientation = quat_normalize(vec4_create((float)rand()/(float)RAND_MAX - 0.5f,
+                                                           (float)rand()/(float)RAND_MAX - 0.5f,
+                                                           (float)rand()/(float)RAND_MAX - 0.5f,
+                                                           (float)rand()/(float)RAND_MAX - 0.5f));
+        transform.position = vec3_create((float)(ii % 100), (float)(ii / 100 % 100), (float)(ii / 10000));
+        transform.scale = 0.5f + (float)rand()/(float)RAND_MAX;
+    }
+
+    printf("%d models, %d passes\n", count, kPasses);
+    printf("  run   per draw ms   batch ms   speedup\n");
+    for(int run=0; run<runs; ++run) {
+        get_delta_time(timer);
+        for(int pass=0; pass<kPasses; ++pass) {
+            for(int ii=0; ii<count; ++ii)
+                uploads[(size_t)ii] = transform_get_matrix(models[(size_t)ii].transform);
+        }
+        double scalar_time = get_delta_time(timer);
+        for(int ii=0; ii<count; ++ii)
+            transforms[(size_t)ii] = &models[(size_t)ii].transform;
+        compute_world_matrices(&matrices[0], &transforms[0], count);
+        for(int pass=0; pass<kPasses; ++pass) {
+            for(int ii=0; ii<count; ++ii)
+                uploads[(size_t)ii] = matrices[(size_t)ii];
+        }
+        double batch_time = get_delta_time(timer);
+        printf("  %3d  %12.3f  %9.3f  %8.2fx\n", run, scalar_time*1000.0, batch_time*1000.0,
+               scalar_time/batch_time);
+    }
+    for(int ii=0; ii<count; ++ii) {
+        Mat4 world = transform_get_matrix(models[(size_t)ii].transform);
+        const float* a = &world.r0.x;
+        const float* b = &matrices[(size_t)ii].r0.x;
+        for(int jj=0; jj<16; ++jj) {
+            float error = a[jj] > b[jj] ? a[jj] - b[jj] : b[jj] - a[jj];
+            if(error > max_error)
+                max_error = error;
+        }
+    }
+    printf("  Largest difference: %g\n", (double)max_error);
+    destroy_timer(timer);
+}
+
+/* External functions
+ */
+int main(int argc, const char *argv[])
+{
+    GeneratorOptions options = { 1000000, 16, 0, 1 };
+    std::string directory("/tmp");
+    int runs = 3;
+    int num_files = 0;
+    int matrices = 0;
+
+    for(int ii=1; ii<argc; ++ii) {
+        const char* arg = argv[ii];
+        const char* value = ii+1 < argc ? argv[ii+1] : NULL;
+        if(strcmp(arg, "--quads") == 0) {
+            options.quads = 1;
+        } else if(strcmp(arg, "--untextured") == 0) {
+            options.textured = 0;
+        } else if(strncmp(arg, "--", 2) == 0 && value == NULL) {
+            printf("%s needs a value\n\n%s", arg, kUsage);
+            return 1;
+        } else if(strcmp(arg, "--triangles") == 0) {
+            options.triangles = strtoul(value, NULL, 10);
+            ++ii;
+        } else if(strcmp(arg, "--groups") == 0) {
+            options.groups = strtoul(value, NULL, 10);
+            ++ii;
+        } else if(strcmp(arg, "--dir") == 0) {
+            directory = value;
+            ++ii;
+        } else if(strcmp(arg, "--runs") == 0) {
+            runs = atoi(value);
+            ++ii;
+        } else if(strcmp(arg, "--threads") == 0) {
+            set_scene_load_threads(atoi(value));
+            ++ii;
+        } else if(strcmp(arg, "--stream") == 0) {
+            set_scene_load_memory_limit((size_t)strtoul(value, NULL, 10));
+            ++ii;
+        } else if(strcmp(arg, "--matrices") == 0) {
+            matrices = atoi(value);
+            ++ii;
+        } else if(strncmp(arg, "--", 2) == 0) {
+            printf("%s", kUsage);
+            return strcmp(arg, "--help") == 0 ? 0 : 1;
+        } else {
+            ++num_files;
+        }
+    }
+    if(options.triangles == 0 || options.groups == 0 || runs < 1) {
+        printf("%s", kUsage);
+        return 1;
+    }
+    if(matrices > 0) {
+        _benchmark_matrices(matrices, runs);
+        return 0;
+    }
+
+    if(num_files == 0) {
+        std::string filename;
+        Timer* timer = create_timer();
+        if(_generate_obj(directory, options, &filename) != 0) {
+            printf("Unable to write to %s\n", directory.c_str());
+            return 1;
+        }
+        printf("Generated %s in %.1f s\n\n", filename.c_str(), get_running_time(timer));
+        destroy_timer(timer);
+        _benchmark_file(filename.c_str(), runs);
+    }
+    for(int ii=1; ii<argc; ++ii) {
+        if(strncmp(argv[ii], "--", 2) == 0) {
+            if(strcmp(argv[ii], "--quads") != 0 && strcmp(argv[ii], "--untextured") != 0)
+                ++ii;
+            continue;
+        }
+        _benchmark_file(argv[ii], runs);
+    }
+    return 0;
+}
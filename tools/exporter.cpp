@@ -3,6 +3,9 @@
 extern "C" {
 #include "../src/utility.h"
 #include "../src/scene.h"
+#include "../src/scene_data.h"
+#include "../src/scene_format.h"
+#include "../src/vertex.h"
 }
 #include <stdlib.h>
 #include <stddef.h>
@@ -11,25 +14,793 @@ extern "C" {
 #include <map>
 #include <stdio.h>
 #include <sstream>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
 
 /* Constants
  */
+static const char kUsage[] =
+    "usage: exporter [--qtangent | --compressed] [--no-optimize] [--no-lods] file.obj ...\n"
+    "  Writes a .mesh file next to each OBJ.\n"
+    "\n"
+    "  --qtangent     Store tangent frames as quaternions (QTangentVertex)\n"
+    "  --compressed   Store quantized vertices (CompressedVertex)\n"
+    "  --no-optimize  Keep the triangle and vertex order of the OBJ\n"
+    "  --no-lods      Don't generate simplified levels of detail\n";
+
+/* Size of the LRU cache Forsyth's scoring models */
+static const int kForsythCacheSize = 32;
+/* Size of the FIFO cache ACMR and ATVR are measured with */
+static const uint32_t kCacheSimulationSize = 16;
+/* A cluster may end once its ACMR is within this factor of the mesh's, so
+ * reordering clusters for overdraw costs little vertex cache efficiency */
+static const float kOverdrawThreshold = 1.05f;
+/* Each level of detail aims for half the triangles of the one before, and
+ * is dropped unless it has at most kMinLodReduction of them */
+static const float kLodTriangleRatio = 0.5f;
+static const float kMinLodReduction = 0.8f;
+/* Meshes this small aren't worth simplifying */
+static const uint32_t kMinLodTriangles = 64;
+/* Largest error, relative to the bounding radius, a collapse may add */
+static const float kMaxLodError = 0.05f;
+/* Smallest cosine between a triangle's normal before and after a collapse */
+static const float kMinCollapseNormalCos = 0.2f;
 
 /* Types
  */
+struct CacheStats
+{
+    uint64_t    misses;
+    uint64_t    triangles;
+    uint64_t    vertices;
+};
+/** Levels of detail of a mesh, consecutive in its indices */
+struct LodChain
+{
+    uint32_t    num_lods;
+    uint32_t    index_count[MESH_FILE_MAX_LODS];
+    float       error[MESH_FILE_MAX_LODS];
+};
+/** Symmetric 4x4 error quadric of a vertex, with the area of the planes
+ *  summed into it */
+struct Quadric
+{
+    double      a[10];
+    double      weight;
+};
+struct Collapse
+{
+    uint32_t    from;
+    uint32_t    to;
+    float       error;
+};
+struct Cluster
+{
+    uint32_t    first_triangle;
+    uint32_t    num_triangles;
+    float       sort_key;
+};
 
 /* Variables
  */
  
 /* Internal functions
  */
+static uint32_t _align(size_t offset)
+{
+    return (uint32_t)((offset + kMeshFileAlignment - 1) & ~(size_t)(kMeshFileAlignment - 1));
+}
+/** The material of the first model using each mesh, or MESH_FILE_NO_MATERIAL
+ */
+static void _find_mesh_materials(const SceneData* scene, std::vector<uint32_t>* mesh_materials)
+{
+    NameIndex mesh_index;
+    NameIndex material_index;
+    _build_name_index(&mesh_index, scene->meshes, sizeof(MeshData), scene->num_meshes);
+    _build_name_index(&material_index, scene->materials, sizeof(MaterialData), scene->num_materials);
+
+    mesh_materials->assign(scene->num_meshes, MESH_FILE_NO_MATERIAL);
+    for(uint32_t ii=0; ii<scene->num_models; ++ii) {
+        uint32_t mesh = _find_name(&mesh_index, scene->meshes, sizeof(MeshData), scene->models[ii].mesh_name);
+        if(mesh == NAME_INDEX_NOT_FOUND || (*mesh_materials)[mesh] != MESH_FILE_NO_MATERIAL)
+            continue;
+        (*mesh_materials)[mesh] = _find_name(&material_index, scene->materials, sizeof(MaterialData),
+                                             scene->models[ii].material_name);
+    }
+    _free_name_index(&mesh_index);
+    _free_name_index(&material_index);
+}
+/** FIFO post-transform cache. A vertex is cached while fewer than
+ *  kCacheSimulationSize misses happened since it was last loaded
+ */
+struct VertexCache
+{
+    std::vector<uint32_t>   load_time;
+    uint32_t                time;
+
+    explicit VertexCache(uint32_t vertex_count)
+        : load_time(vertex_count, 0)
+        , time(kCacheSimulationSize + 1)
+    {
+    }
+    bool contains(uint32_t vertex) const
+    {
+        return time - load_time[vertex] <= kCacheSimulationSize;
+    }
+    /** @return 1 if `vertex` had to be transformed */
+    uint32_t load(uint32_t vertex)
+    {
+        if(contains(vertex))
+            return 0;
+        load_time[vertex] = time++;
+        return 1;
+    }
+    void flush()
+    {
+        time += kCacheSimulationSize + 1;
+    }
+};
+static uint32_t _count_cache_misses(const uint32_t* indices, uint32_t index_count, uint32_t vertex_count)
+{
+    VertexCache cache(vertex_count);
+    uint32_t misses = 0;
+    for(uint32_t ii=0; ii<index_count; ++ii)
+        misses += cache.load(indices[ii]);
+    return misses;
+}
+static void _add_cache_stats(const MeshData& mesh, uint32_t index_count, CacheStats* stats)
+{
+    stats->misses += _count_cache_misses(mesh.indices, index_count, mesh.vertex_count);
+    stats->triangles += index_count/3;
+    stats->vertices += mesh.vertex_count;
+}
+static float _forsyth_vertex_score(int cache_position, uint32_t remaining_triangles)
+{
+    float score = 0.0f;
+    if(remaining_triangles == 0)
+        return -1.0f;
+    if(cache_position >= 0) {
+        if(cache_position < 3) /* The last triangle's vertices */
+            score = 0.75f;
+        else
+            score = powf(1.0f - (float)(cache_position - 3)/(float)(kForsythCacheSize - 3), 1.5f);
+    }
+    return score + 2.0f/sqrtf((float)remaining_triangles);
+}
+/** Tom Forsyth's "Linear-Speed Vertex Cache Optimisation": greedily emits
+ *  the triangle whose vertices score highest in a simulated LRU cache
+ */
+static void _optimize_vertex_cache(uint32_t* indices, uint32_t index_count, uint32_t vertex_count)
+{
+    uint32_t num_triangles = index_count/3;
+    if(num_triangles == 0)
+        return;
+
+    /* Triangles using each vertex. The first `remaining` of each list are
+     * the ones not emitted yet */
+    std::vector<uint32_t> first_triangle(vertex_count + 1, 0);
+    std::vector<uint32_t> remaining(vertex_count, 0);
+    std::vector<uint32_t> vertex_triangles(num_triangles*3);
+    for(uint32_t ii=0; ii<num_triangles*3; ++ii)
+        ++first_triangle[indices[ii] + 1];
+    for(uint32_t ii=0; ii<vertex_count; ++ii) {
+        remaining[ii] = first_triangle[ii + 1];
+        first_triangle[ii + 1] += first_triangle[ii];
+    }
+    std::vector<uint32_t> fill(first_triangle.begin(), first_triangle.end() - 1);
+    for(uint32_t ii=0; ii<num_triangles*3; ++ii)
+        vertex_triangles[fill[indices[ii]]++] = ii/3;
+
+    std::vector<int> cache_position(vertex_count, -1);
+    std::vector<float> vertex_score(vertex_count);
+    std::vector<float> triangle_score(num_triangles, 0.0f);
+    std::vector<uint8_t> emitted(num_triangles, 0);
+    for(uint32_t ii=0; ii<vertex_count; ++ii)
+        vertex_score[ii] = _forsyth_vertex_score(-1, remaining[ii]);
+    for(uint32_t ii=0; ii<num_triangles*3; ++ii)
+        triangle_score[ii/3] += vertex_score[indices[ii]];
+
+    std::vector<uint32_t> output(num_triangles*3);
+    uint32_t cache[kForsythCacheSize + 3];
+    uint32_t new_cache[kForsythCacheSize + 3];
+    int cache_size = 0;
+    uint32_t next_unemitted = 0;
+    uint32_t best = 0;
+    for(uint32_t emitted_count=0; emitted_count<num_triangles; ++emitted_count) {
+        /* Nothing in the cache scored, fall back to input order */
+        if(emitted[best]) {
+            while(emitted[next_unemitted])
+                ++next_unemitted;
+            best = next_unemitted;
+        }
+        const uint32_t* triangle = indices + best*3;
+        memcpy(&output[emitted_count*3], triangle, 3*sizeof(uint32_t));
+        emitted[best] = 1;
+
+        /* Retire the triangle from its vertices' lists */
+        for(int jj=0; jj<3; ++jj) {
+            uint32_t vertex = triangle[jj];
+            uint32_t* list = &vertex_triangles[first_triangle[vertex]];
+            for(uint32_t kk=0; kk<remaining[vertex]; ++kk) {
+                if(list[kk] == best) {
+                    list[kk] = list[--remaining[vertex]];
+                    list[remaining[vertex]] = best;
+                    break;
+                }
+            }
+        }
+
+        /* Move its vertices to the front of the cache */
+        int new_size = 0;
+        for(int jj=0; jj<3; ++jj) {
+            if(jj > 0 && triangle[jj] == triangle[0])
+                continue;
+            if(jj > 1 && triangle[jj] == triangle[1])
+                continue;
+            new_cache[new_size++] = triangle[jj];
+        }
+        for(int jj=0; jj<cache_size; ++jj) {
+            uint32_t vertex = cache[jj];
+            if(vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+                new_cache[new_size++] = vertex;
+        }
+
+        /* Rescore everything that was or is in the cache */
+        for(int jj=0; jj<new_size; ++jj) {
+            uint32_t vertex = new_cache[jj];
+            int position = jj < kForsythCacheSize ? jj : -1;
+            float score = _forsyth_vertex_score(position, remaining[vertex]);
+            float delta = score - vertex_score[vertex];
+            cache_position[vertex] = position;
+            vertex_score[vertex] = score;
+            for(uint32_t kk=0; kk<remaining[vertex]; ++kk)
+                triangle_score[vertex_triangles[first_triangle[vertex] + kk]] += delta;
+        }
+        cache_size = new_size < kForsythCacheSize ? new_size : kForsythCacheSize;
+        memcpy(cache, new_cache, (size_t)cache_size*sizeof(uint32_t));
+
+        /* The next triangle is the best one touching the cache */
+        float best_score = -1.0f;
+        for(int jj=0; jj<cache_size; ++jj) {
+            uint32_t vertex = cache[jj];
+            for(uint32_t kk=0; kk<remaining[vertex]; ++kk) {
+                uint32_t candidate = vertex_triangles[first_triangle[vertex] + kk];
+                if(triangle_score[candidate] > best_score) {
+                    best_score = triangle_score[candidate];
+                    best = candidate;
+                }
+            }
+        }
+        if(best_score < 0.0f)
+            best = next_unemitted;
+    }
+    memcpy(indices, &output[0], output.size()*sizeof(uint32_t));
+}
+static bool _cluster_sort_greater(const Cluster& a, const Cluster& b)
+{
+    return a.sort_key > b.sort_key;
+}
+/** Sander et al., "Fast Triangle Reordering for Vertex Locality and Reduced
+ *  Overdraw". The cache-ordered triangles are cut into clusters, where all
+ *  three vertices of a triangle miss the cache or where the cluster's ACMR,
+ *  cold start included, is already close to the mesh's. Clusters facing
+ *  away from the mesh center, which tend to occlude the rest, are drawn
+ *  first
+ */
+static void _optimize_overdraw(uint32_t* indices, uint32_t index_count, const Vertex* vertices, uint32_t vertex_count)
+{
+    uint32_t num_triangles = index_count/3;
+    if(num_triangles == 0)
+        return;
+    float target_acmr = kOverdrawThreshold*(float)_count_cache_misses(indices, index_count, vertex_count)/(float)num_triangles;
+
+    /* Clusters are measured from a cold cache, as they may end up anywhere */
+    std::vector<Cluster> clusters;
+    VertexCache cache(vertex_count);
+    uint32_t cluster_misses = 0;
+    for(uint32_t ii=0; ii<num_triangles; ++ii) {
+        const uint32_t* triangle = indices + ii*3;
+        int cached = cache.contains(triangle[0]) + cache.contains(triangle[1]) + cache.contains(triangle[2]);
+        bool split = clusters.empty() || cached == 0;
+        if(!split && cached < 3)
+            split = (float)cluster_misses <= target_acmr*(float)clusters.back().num_triangles;
+        if(split) {
+            Cluster cluster = { ii, 0, 0.0f };
+            clusters.push_back(cluster);
+            cluster_misses = 0;
+            cache.flush();
+        }
+        ++clusters.back().num_triangles;
+        for(int jj=0; jj<3; ++jj)
+            cluster_misses += cache.load(triangle[jj]);
+    }
+
+    /* Area weighted centroids and normals */
+    Vec3 mesh_centroid = vec3_create(0.0f, 0.0f, 0.0f);
+    float mesh_area = 0.0f;
+    std::vector<Vec3> centroids(clusters.size());
+    std::vector<Vec3> normals(clusters.size());
+    for(size_t ii=0; ii<clusters.size(); ++ii) {
+        Vec3 centroid = vec3_create(0.0f, 0.0f, 0.0f);
+        Vec3 normal = vec3_create(0.0f, 0.0f, 0.0f);
+        float area = 0.0f;
+        for(uint32_t jj=0; jj<clusters[ii].num_triangles; ++jj) {
+            const uint32_t* triangle = indices + (clusters[ii].first_triangle + jj)*3;
+            Vec3 a = vertices[triangle[0]].position;
+            Vec3 b = vertices[triangle[1]].position;
+            Vec3 c = vertices[triangle[2]].position;
+            Vec3 cross = vec3_cross(vec3_sub(b, a), vec3_sub(c, a));
+            float triangle_area = vec3_length(cross);
+            centroid = vec3_add(centroid, vec3_mul_scalar(vec3_add(vec3_add(a, b), c), triangle_area/3.0f));
+            normal = vec3_add(normal, cross);
+            area += triangle_area;
+        }
+        mesh_centroid = vec3_add(mesh_centroid, centroid);
+        mesh_area += area;
+        centroids[ii] = area > 0.0f ? vec3_mul_scalar(centroid, 1.0f/area) : centroid;
+        normals[ii] = vec3_length_sq(normal) > 0.0f ? vec3_normalize(normal) : normal;
+    }
+    if(mesh_area > 0.0f)
+        mesh_centroid = vec3_mul_scalar(mesh_centroid, 1.0f/mesh_area);
+    for(size_t ii=0; ii<clusters.size(); ++ii)
+        clusters[ii].sort_key = vec3_dot(vec3_sub(centroids[ii], mesh_centroid), normals[ii]);
+    std::stable_sort(clusters.begin(), clusters.end(), _cluster_sort_greater);
+
+    std::vector<uint32_t> output;
+    output.reserve(num_triangles*3);
+    for(size_t ii=0; ii<clusters.size(); ++ii) {
+        const uint32_t* first = indices + clusters[ii].first_triangle*3;
+        output.insert(output.end(), first, first + clusters[ii].num_triangles*3);
+    }
+    memcpy(indices, &output[0], output.size()*sizeof(uint32_t));
+}
+/** Renumbers vertices in the order the triangles first use them, so vertex
+ *  fetches walk the buffer forwards. Unused vertices go last
+ */
+static void _optimize_vertex_fetch(Vertex* vertices, uint32_t vertex_count, uint32_t* indices, uint32_t index_count)
+{
+    const uint32_t kUnused = 0xFFFFFFFFu;
+    std::vector<uint32_t> remap(vertex_count, kUnused);
+    std::vector<Vertex> reordered(vertex_count);
+    uint32_t next = 0;
+    for(uint32_t ii=0; ii<index_count; ++ii) {
+        uint32_t& vertex = remap[indices[ii]];
+        if(vertex == kUnused) {
+            vertex = next++;
+            reordered[vertex] = vertices[indices[ii]];
+        }
+        indices[ii] = vertex;
+    }
+    for(uint32_t ii=0; ii<vertex_count; ++ii) {
+        if(remap[ii] == kUnused)
+            reordered[next++] = vertices[ii];
+    }
+    if(vertex_count)
+        memcpy(vertices, &reordered[0], vertex_count*sizeof(Vertex));
+}
+static void _add_plane_quadric(Quadric* q, double a, double b, double c, double d, double weight)
+{
+    q->a[0] += weight*a*a; q->a[1] += weight*a*b; q->a[2] += weight*a*c; q->a[3] += weight*a*d;
+    q->a[4] += weight*b*b; q->a[5] += weight*b*c; q->a[6] += weight*b*d;
+    q->a[7] += weight*c*c; q->a[8] += weight*c*d;
+    q->a[9] += weight*d*d;
+    q->weight += weight;
+}
+static void _add_quadric(Quadric* q, const Quadric& other)
+{
+    for(int ii=0; ii<10; ++ii)
+        q->a[ii] += other.a[ii];
+    q->weight += other.weight;
+}
+/** @return The area weighted mean squared distance from `p` to the planes
+ *      of `a` and `b` combined
+ */
+static float _quadric_error(const Quadric& a, const Quadric& b, Vec3 p)
+{
+    double x = p.x, y = p.y, z = p.z;
+    double q[10];
+    double weight = a.weight + b.weight;
+    for(int ii=0; ii<10; ++ii)
+        q[ii] = a.a[ii] + b.a[ii];
+    double error = q[0]*x*x + 2*q[1]*x*y + 2*q[2]*x*z + 2*q[3]*x
+                 + q[4]*y*y + 2*q[5]*y*z + 2*q[6]*y
+                 + q[7]*z*z + 2*q[8]*z
+                 + q[9];
+    if(weight <= 0.0 || error <= 0.0)
+        return 0.0f;
+    return (float)sqrt(error/weight);
+}
+static void _mesh_bounds(const MeshData& mesh, Vec3* center, float* radius)
+{
+    Vec3 min = vec3_zero, max = vec3_zero;
+    for(uint32_t ii=0; ii<mesh.vertex_count; ++ii) {
+        min = ii ? vec3_min(min, mesh.vertices[ii].position) : mesh.vertices[ii].position;
+        max = ii ? vec3_max(max, mesh.vertices[ii].position) : mesh.vertices[ii].position;
+    }
+    *center = vec3_mul_scalar(vec3_add(min, max), 0.5f);
+    *radius = vec3_length(vec3_sub(max, min))*0.5f;
+}
+static bool _collapse_sort_less(const Collapse& a, const Collapse& b)
+{
+    return a.error < b.error;
+}
+/** @return false if moving `from` onto `to` would flip or squash one of the
+ *      triangles around `from` that survive the collapse
+ */
+static bool _collapse_keeps_normals(const Vertex* vertices, const std::vector<uint32_t>& indices,
+                                    const std::vector<uint32_t>& triangles, uint32_t from, uint32_t to)
+{
+    for(size_t ii=0; ii<triangles.size(); ++ii) {
+        const uint32_t* triangle = &indices[triangles[ii]*3];
+        if(triangle[0] == to || triangle[1] == to || triangle[2] == to)
+            continue;
+        Vec3 p[3], q[3];
+        for(int jj=0; jj<3; ++jj) {
+            p[jj] = vertices[triangle[jj]].position;
+            q[jj] = triangle[jj] == from ? vertices[to].position : p[jj];
+        }
+        Vec3 before = vec3_cross(vec3_sub(p[1], p[0]), vec3_sub(p[2], p[0]));
+        Vec3 after = vec3_cross(vec3_sub(q[1], q[0]), vec3_sub(q[2], q[0]));
+        float lengths = vec3_length(before)*vec3_length(after);
+        if(lengths <= 0.0f || vec3_dot(before, after) < kMinCollapseNormalCos*lengths)
+            return false;
+    }
+    return true;
+}
+/** Garland and Heckbert's quadric error simplification, restricted to
+ *  half-edge collapses so every level shares the mesh's vertices. Each pass
+ *  collapses the cheapest edges whose neighborhoods don't overlap. Border
+ *  vertices, which include UV and normal seams, never move
+ *  @param max_error  Collapses costing more than this stop the simplification
+ *  @return The largest error of the collapses made so far
+ */
+static float _simplify(const MeshData& mesh, std::vector<uint32_t>* indices, std::vector<Quadric>* quadrics,
+                       const std::vector<bool>& locked, uint32_t target_triangles, float max_error, float error)
+{
+    const Vertex* vertices = mesh.vertices;
+    uint32_t vertex_count = mesh.vertex_count;
+    std::vector<std::vector<uint32_t> > vertex_triangles(vertex_count);
+    std::vector<uint32_t> remap(vertex_count);
+    std::vector<bool> touched(vertex_count);
+    std::vector<Collapse> collapses;
+    while(indices->size()/3 > target_triangles) {
+        uint32_t num_triangles = (uint32_t)(indices->size()/3);
+        for(uint32_t ii=0; ii<vertex_count; ++ii) {
+            vertex_triangles[ii].clear();
+            remap[ii] = ii;
+        }
+        for(uint32_t ii=0; ii<num_triangles; ++ii) {
+            for(int jj=0; jj<3; ++jj)
+                vertex_triangles[(*indices)[ii*3+jj]].push_back(ii);
+        }
+
+        /* The cheaper direction of every edge, listed by its first triangle */
+        collapses.clear();
+        for(uint32_t ii=0; ii<num_triangles*3; ++ii) {
+            uint32_t a = (*indices)[ii];
+            uint32_t b = (*indices)[ii - ii%3 + (ii+1)%3];
+            if(a > b)
+                std::swap(a, b);
+            Collapse collapse = { 0, 0, 0.0f };
+            bool valid = false;
+            if(!locked[a]) {
+                collapse.from = a, collapse.to = b;
+                collapse.error = _quadric_error((*quadrics)[a], (*quadrics)[b], vertices[b].position);
+                valid = true;
+            }
+            if(!locked[b]) {
+                float reverse = _quadric_error((*quadrics)[a], (*quadrics)[b], vertices[a].position);
+                if(!valid || reverse < collapse.error) {
+                    collapse.from = b, collapse.to = a;
+                    collapse.error = reverse;
+                }
+                valid = true;
+            }
+            if(valid && collapse.error <= max_error)
+                collapses.push_back(collapse);
+        }
+        std::sort(collapses.begin(), collapses.end(), _collapse_sort_less);
+
+        /* Collapse while the neighborhoods stay independent */
+        uint32_t removed = 0;
+        touched.assign(vertex_count, false);
+        for(size_t ii=0; ii<collapses.size() && num_triangles - removed > target_triangles; ++ii) {
+            const Collapse& collapse = collapses[ii];
+            if(touched[collapse.from] || touched[collapse.to] ||
+               !_collapse_keeps_normals(vertices, *indices, vertex_triangles[collapse.from], collapse.from, collapse.to))
+                continue;
+            const std::vector<uint32_t>& triangles = vertex_triangles[collapse.from];
+            for(size_t jj=0; jj<triangles.size(); ++jj) {
+                const uint32_t* triangle = &(*indices)[triangles[jj]*3];
+                for(int kk=0; kk<3; ++kk)
+                    touched[triangle[kk]] = true;
+                if(triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+                    ++removed;
+            }
+            remap[collapse.from] = collapse.to;
+            _add_quadric(&(*quadrics)[collapse.to], (*quadrics)[collapse.from]);
+            error = std::max(error, collapse.error);
+        }
+        if(removed == 0)
+            break;
+
+        /* Apply the collapses and drop the degenerate triangles */
+        size_t output = 0;
+        for(size_t ii=0; ii<indices->size(); ii+=3) {
+            uint32_t a = remap[(*indices)[ii+0]];
+            uint32_t b = remap[(*indices)[ii+1]];
+            uint32_t c = remap[(*indices)[ii+2]];
+            if(a == b || b == c || c == a)
+                continue;
+            (*indices)[output++] = a;
+            (*indices)[output++] = b;
+            (*indices)[output++] = c;
+        }
+        indices->resize(output);
+    }
+    return error;
+}
+/** Appends simplified levels of detail to the indices of every mesh
+ */
+static void _generate_lods(const char* filename, SceneData* scene, std::vector<LodChain>* chains)
+{
+    uint64_t lod_triangles[MESH_FILE_MAX_LODS] = { 0 };
+    for(uint32_t ii=0; ii<scene->num_meshes; ++ii) {
+        MeshData& mesh = scene->meshes[ii];
+        LodChain& chain = (*chains)[ii];
+        uint32_t num_triangles = mesh.index_count/3;
+        Vec3 center;
+        float radius;
+        _mesh_bounds(mesh, &center, &radius);
+        if(num_triangles < kMinLodTriangles || radius <= 0.0f)
+            continue;
+
+        /* Plane quadrics, and the vertices on borders or non-manifold edges */
+        std::vector<Quadric> quadrics(mesh.vertex_count);
+        std::vector<bool> locked(mesh.vertex_count, false);
+        std::map<std::pair<uint32_t, uint32_t>, uint32_t> edge_triangles;
+        memset(&quadrics[0], 0, quadrics.size()*sizeof(Quadric));
+        for(uint32_t jj=0; jj<num_triangles; ++jj) {
+            const uint32_t* triangle = mesh.indices + jj*3;
+            Vec3 p0 = mesh.vertices[triangle[0]].position;
+            Vec3 normal = vec3_cross(vec3_sub(mesh.vertices[triangle[1]].position, p0),
+                                     vec3_sub(mesh.vertices[triangle[2]].position, p0));
+            float length = vec3_length(normal);
+            if(length > 0.0f) {
+                normal = vec3_div_scalar(normal, length);
+                for(int kk=0; kk<3; ++kk)
+                    _add_plane_quadric(&quadrics[triangle[kk]], normal.x, normal.y, normal.z,
+                                       -vec3_dot(normal, p0), length*0.5f);
+            }
+            for(int kk=0; kk<3; ++kk) {
+                uint32_t a = triangle[kk], b = triangle[(kk+1)%3];
+                ++edge_triangles[std::make_pair(std::min(a, b), std::max(a, b))];
+            }
+        }
+        std::map<std::pair<uint32_t, uint32_t>, uint32_t>::const_iterator edge;
+        for(edge = edge_triangles.begin(); edge != edge_triangles.end(); ++edge) {
+            if(edge->second != 2)
+                locked[edge->first.first] = locked[edge->first.second] = true;
+        }
+
+        /* Each level continues simplifying the one before */
+        std::vector<uint32_t> lod(mesh.indices, mesh.indices + mesh.index_count);
+        std::vector<uint32_t> output(lod);
+        float error = 0.0f;
+        uint32_t target = num_triangles;
+        chain.num_lods = 1;
+        chain.index_count[0] = mesh.index_count;
+        chain.error[0] = 0.0f;
+        while(chain.num_lods < MESH_FILE_MAX_LODS) {
+            uint32_t previous = chain.index_count[chain.num_lods-1]/3;
+            target = (uint32_t)((float)target*kLodTriangleRatio);
+            if(target < kMinLodTriangles/2)
+                break;
+            error = _simplify(mesh, &lod, &quadrics, locked, target, kMaxLodError*radius, error);
+            if((float)(lod.size()/3) > (float)previous*kMinLodReduction || lod.empty())
+                break;
+            output.insert(output.end(), lod.begin(), lod.end());
+            chain.index_count[chain.num_lods] = (uint32_t)lod.size();
+            chain.error[chain.num_lods] = error/radius;
+            ++chain.num_lods;
+        }
+        if(chain.num_lods == 1)
+            continue;
+        free(mesh.indices);
+        mesh.indices = (uint32_t*)malloc(output.size()*sizeof(uint32_t));
+        memcpy(mesh.indices, &output[0], output.size()*sizeof(uint32_t));
+        mesh.index_count = (uint32_t)output.size();
+    }
+    for(uint32_t ii=0; ii<scene->num_meshes; ++ii) {
+        for(uint32_t jj=0; jj<(*chains)[ii].num_lods; ++jj)
+            lod_triangles[jj] += (*chains)[ii].index_count[jj]/3;
+    }
+    printf("%s: LOD triangles", filename);
+    for(uint32_t ii=0; ii<MESH_FILE_MAX_LODS && lod_triangles[ii]; ++ii)
+        printf(" %s%llu", ii ? "/ " : "", (unsigned long long)lod_triangles[ii]);
+    printf("\n");
+}
+/** Optimizes each level of detail on its own, then orders the shared
+ *  vertices by their first use. Cache statistics are for the finest level
+ */
+static void _optimize_scene(const char* filename, SceneData* scene, const std::vector<LodChain>& chains)
+{
+    CacheStats before = { 0, 0, 0 };
+    CacheStats after = { 0, 0, 0 };
+    for(uint32_t ii=0; ii<scene->num_meshes; ++ii) {
+        MeshData& mesh = scene->meshes[ii];
+        const LodChain& chain = chains[ii];
+        _add_cache_stats(mesh, chain.index_count[0], &before);
+        uint32_t* indices = mesh.indices;
+        for(uint32_t jj=0; jj<chain.num_lods; ++jj) {
+            _optimize_vertex_cache(indices, chain.index_count[jj], mesh.vertex_count);
+            _optimize_overdraw(indices, chain.index_count[jj], mesh.vertices, mesh.vertex_count);
+            indices += chain.index_count[jj];
+        }
+        _optimize_vertex_fetch(mesh.vertices, mesh.vertex_count, mesh.indices, mesh.index_count);
+        _add_cache_stats(mesh, chain.index_count[0], &after);
+    }
+    if(before.triangles == 0)
+        return;
+    printf("%s: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f (%u entry FIFO)\n", filename,
+           (double)before.misses/(double)before.triangles, (double)after.misses/(double)after.triangles,
+           (double)before.misses/(double)before.vertices, (double)after.misses/(double)after.vertices,
+           kCacheSimulationSize);
+}
+static std::string _mesh_filename(const char* filename)
+{
+    std::string mesh_filename(filename);
+    size_t extension = mesh_filename.rfind('.');
+    size_t directory = mesh_filename.find_last_of("/\\");
+    if(extension != std::string::npos && (directory == std::string::npos || extension > directory))
+        mesh_filename.erase(extension);
+    return mesh_filename + ".mesh";
+}
+static int _write_mesh_file(const char* filename, const SceneData* scene, const std::vector<LodChain>& chains,
+                            VertexFormat vertex_format)
+{
+    size_t vertex_size = get_vertex_size(vertex_format);
+    MeshFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "MESH", sizeof(header.magic));
+    header.version = kMeshFileVersion;
+    header.vertex_size = (uint32_t)vertex_size;
+    header.vertex_format = vertex_format;
+    header.num_meshes = scene->num_meshes;
+    header.num_materials = scene->num_materials;
+
+    /* Lay out the tables, then each mesh's vertices and indices */
+    size_t offset = sizeof(header);
+    header.mesh_offset = _align(offset);
+    offset = header.mesh_offset + scene->num_meshes*sizeof(MeshFileMesh);
+    header.material_offset = _align(offset);
+    offset = header.material_offset + scene->num_materials*sizeof(MeshFileMaterial);
+
+    std::vector<uint32_t> mesh_materials;
+    _find_mesh_materials(scene, &mesh_materials);
+
+    std::vector<MeshFileMesh> meshes(scene->num_meshes);
+    for(uint32_t ii=0; ii<scene->num_meshes; ++ii) {
+        const MeshData& src = scene->meshes[ii];
+        MeshFileMesh& mesh = meshes[ii];
+        memset(&mesh, 0, sizeof(mesh));
+        memcpy(mesh.name, src.name, sizeof(mesh.name));
+        mesh.vertex_count = src.vertex_count;
+        mesh.index_count = src.index_count;
+        mesh.material = mesh_materials[ii];
+        mesh.num_lods = chains[ii].num_lods;
+        memcpy(mesh.lod_index_count, chains[ii].index_count, sizeof(mesh.lod_index_count));
+        memcpy(mesh.lod_error, chains[ii].error, sizeof(mesh.lod_error));
+        if(vertex_format == kVertexFormatCompressed) {
+            PositionQuantization quantization = get_position_quantization(src.vertices, src.vertex_count);
+            memcpy(mesh.position_scale, &quantization.scale, sizeof(mesh.position_scale));
+            memcpy(mesh.position_bias, &quantization.bias, sizeof(mesh.position_bias));
+        }
+        mesh.vertex_offset = _align(offset);
+        offset = mesh.vertex_offset + src.vertex_count*vertex_size;
+        mesh.index_offset = _align(offset);
+        offset = mesh.index_offset + src.index_count*sizeof(uint32_t);
+    }
+    offset = _align(offset);
+    if(offset > 0xFFFFFFFFu) {
+        printf("%s would be larger than 4GB\n", filename);
+        return -1;
+    }
+    header.file_size = (uint32_t)offset;
+
+    std::vector<char> data(offset, 0);
+    memcpy(&data[0], &header, sizeof(header));
+    if(!meshes.empty())
+        memcpy(&data[header.mesh_offset], &meshes[0], meshes.size()*sizeof(MeshFileMesh));
+    for(uint32_t ii=0; ii<scene->num_materials; ++ii) {
+        const MaterialData& src = scene->materials[ii];
+        MeshFileMaterial material;
+        memset(&material, 0, sizeof(material));
+        memcpy(material.name, src.name, sizeof(material.name));
+        memcpy(material.albedo_tex, src.albedo_tex, sizeof(material.albedo_tex));
+        memcpy(material.normal_tex, src.normal_tex, sizeof(material.normal_tex));
+        material.specular_color[0] = src.specular_color.x;
+        material.specular_color[1] = src.specular_color.y;
+        material.specular_color[2] = src.specular_color.z;
+        material.specular_power = src.specular_power;
+        material.specular_coefficient = src.specular_coefficient;
+        memcpy(&data[header.material_offset + ii*sizeof(material)], &material, sizeof(material));
+    }
+    for(uint32_t ii=0; ii<scene->num_meshes; ++ii) {
+        const MeshData& src = scene->meshes[ii];
+        if(vertex_format == kVertexFormatQTangent) {
+            pack_qtangent_vertices((QTangentVertex*)&data[meshes[ii].vertex_offset], src.vertices, src.vertex_count);
+        } else if(vertex_format == kVertexFormatCompressed) {
+            PositionQuantization quantization;
+            quantization.scale = vec3_create(meshes[ii].position_scale[0], meshes[ii].position_scale[1], meshes[ii].position_scale[2]);
+            quantization.bias = vec3_create(meshes[ii].position_bias[0], meshes[ii].position_bias[1], meshes[ii].position_bias[2]);
+            compress_vertices((CompressedVertex*)&data[meshes[ii].vertex_offset], src.vertices, src.vertex_count, &quantization);
+        } else
+            memcpy(&data[meshes[ii].vertex_offset], src.vertices, src.vertex_count*sizeof(Vertex));
+        memcpy(&data[meshes[ii].index_offset], src.indices, src.index_count*sizeof(uint32_t));
+    }
+
+    FILE* file = fopen(filename, "wb");
+    if(file == NULL) {
+        printf("Unable to open %s for writing\n", filename);
+        return -1;
+    }
+    size_t written = fwrite(&data[0], data.size(), 1, file);
+    fclose(file);
+    if(written != 1) {
+        printf("Unable to write %s\n", filename);
+        return -1;
+    }
+    printf("%s: %u meshes, %u materials, %u bytes\n", filename, header.num_meshes, header.num_materials, header.file_size);
+    return 0;
+}
 
 /* External functions
  */
 int main(int argc, const char *argv[])
 {
+    int result = 0;
+    VertexFormat vertex_format = kVertexFormatFloat;
+    bool optimize = true;
+    bool lods = true;
     for(int ii=1; ii<argc;++ii) {
+        if(strcmp(argv[ii], "--no-optimize") == 0) {
+            optimize = false;
+        } else if(strcmp(argv[ii], "--no-lods") == 0) {
+            lods = false;
+        } else if(strcmp(argv[ii], "--qtangent") == 0) {
+            vertex_format = kVertexFormatQTangent;
+        } else if(strcmp(argv[ii], "--compressed") == 0) {
+            vertex_format = kVertexFormatCompressed;
+        } else if(strncmp(argv[ii], "--", 2) == 0) {
+            printf("%s", kUsage);
+            return strcmp(argv[ii], "--help") == 0 ? 0 : 1;
+        }
+    }
+    for(int ii=1; ii<argc;++ii) {
+        if(strncmp(argv[ii], "--", 2) == 0)
+            continue;
         SceneData* scene = _load_scene_data(argv[ii]);
+        if(scene == NULL) {
+            printf("Unable to load %s\n", argv[ii]);
+            result = 1;
+            continue;
+        }
+        /* Every mesh starts as a single level of detail */
+        std::vector<LodChain> chains(scene->num_meshes);
+        for(uint32_t jj=0; jj<scene->num_meshes; ++jj) {
+            memset(&chains[jj], 0, sizeof(LodChain));
+            chains[jj].num_lods = 1;
+            chains[jj].index_count[0] = scene->meshes[jj].index_count;
+        }
+        if(lods)
+            _generate_lods(argv[ii], scene, &chains);
+        if(optimize)
+            _optimize_scene(argv[ii], scene, chains);
+        if(_write_mesh_file(_mesh_filename(argv[ii]).c_str(), scene, chains, vertex_format) != 0)
+            result = 1;
+        _free_scene_data(scene);
     }
-    return 0;
+    return result;
 }